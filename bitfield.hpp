@@ -0,0 +1,228 @@
+//------------------------------------------------------------------------------
+//
+//  Bitboard field: same interface as Field, but for fields up to 64 cells
+//
+//------------------------------------------------------------------------------
+//
+// Cell (x, y) is bit y * N + x of 64-bit occupancy mask. Say for 4x3 field
+// block 2x2 at position (1, 0) is
+//
+//  -xx-
+//  -xx-    mask = 0b0000'0110'0110
+//  ----
+//
+// which is row mask 0b0110 times column mask 0b0001'0001. So placement is
+// one test-and-set and next free cell is count of trailing ones.
+//
+// Block numbers per cell are not stored at all: each block remembers its
+// mask and cells are restored on demand (dump and vtype are only called for
+// tight pavings, which are rare).
+//
+// Sizes come from Dims policy:
+//
+//  BitField          -- N and M are given at runtime
+//  FixedField<N, M>  -- N and M are compile-time constants, so all masks
+//                       are constants and storage is exactly N * M cells
+//
+//------------------------------------------------------------------------------
+
+#ifndef BITFIELD_GUARD_
+#define BITFIELD_GUARD_
+
+#include <array>
+#include <cassert>
+#include <cstdint>
+#include <iostream>
+#include <vector>
+
+#include "field.hpp"
+
+// helper: len cells in a column of field with width n: bits 0, n, 2n, ...
+constexpr uint64_t bitfield_column(size_t n, size_t len) {
+  uint64_t res = 0;
+  for (size_t idx = 0; idx < len; ++idx)
+    res |= uint64_t(1) << (idx * n);
+  return res;
+}
+
+struct DynamicDims {
+  size_t N;
+  size_t M;
+  static constexpr size_t maxcells = 64;
+  std::array<uint64_t, maxcells + 1> colmask_;
+
+  DynamicDims(size_t horz, size_t vert) : N(horz), M(vert) {
+    assert(N * M <= 64 && "Bitboard is only for fields up to 64 cells");
+    for (size_t len = 0; len <= M; ++len)
+      colmask_[len] = bitfield_column(N, len);
+  }
+
+  uint64_t colmask(size_t len) const { return colmask_[len]; }
+};
+
+template <size_t H, size_t V> struct StaticDims {
+  static_assert(H * V <= 64, "Bitboard is only for fields up to 64 cells");
+  static constexpr size_t N = H;
+  static constexpr size_t M = V;
+  static constexpr size_t maxcells = H * V;
+
+  StaticDims(size_t horz, size_t vert) {
+    assert((horz == H) && (vert == V));
+  }
+
+  static constexpr uint64_t colmask(size_t len) {
+    return bitfield_column(N, len);
+  }
+};
+
+template <typename Dims> class BasicBitField : Dims {
+  using Dims::M;
+  using Dims::maxcells;
+  using Dims::N;
+
+  uint64_t occ_ = 0;
+
+  // blocks_[num] is mask of block num
+  std::array<uint64_t, maxcells + 1> blocks_;
+
+  // counters of block edges on each coordinate line and masks of lines,
+  // which have nonzero counter
+  std::array<unsigned char, maxcells> hcoord_{};
+  std::array<unsigned char, maxcells> vcoord_{};
+  uint64_t hused_ = 0;
+  uint64_t vused_ = 0;
+
+  size_t pos_ = 0;
+  size_t curnum_ = 1;
+
+  uint64_t full() const {
+    return (N * M == 64) ? ~uint64_t(0) : (uint64_t(1) << (N * M)) - 1;
+  }
+
+  // helper: first unoccupied cell or M * N if there is no such
+  size_t first_free() const {
+    uint64_t fr = ~occ_ & full();
+    return fr ? __builtin_ctzll(fr) : M * N;
+  }
+
+  // helper: restore block numbers per cell
+  std::array<unsigned char, maxcells> cells() const {
+    std::array<unsigned char, maxcells> fld{};
+    for (size_t num = 1; num < curnum_; ++num)
+      for (uint64_t b = blocks_[num]; b != 0; b &= b - 1)
+        fld[__builtin_ctzll(b)] = num;
+    return fld;
+  }
+
+  void mark(size_t hpos, size_t vpos, size_t hlen, size_t vlen) {
+    if (hpos + hlen < N && hcoord_[hpos + hlen - 1]++ == 0)
+      hused_ |= uint64_t(1) << (hpos + hlen - 1);
+
+    if (vpos + vlen < M && vcoord_[vpos + vlen - 1]++ == 0)
+      vused_ |= uint64_t(1) << (vpos + vlen - 1);
+  }
+
+  void unmark(size_t hpos, size_t vpos, size_t hlen, size_t vlen) {
+    if (hpos + hlen < N && --hcoord_[hpos + hlen - 1] == 0)
+      hused_ &= ~(uint64_t(1) << (hpos + hlen - 1));
+
+    if (vpos + vlen < M && --vcoord_[vpos + vlen - 1] == 0)
+      vused_ &= ~(uint64_t(1) << (vpos + vlen - 1));
+  }
+
+public:
+  BasicBitField(size_t horz, size_t vert) : Dims(horz, vert) {}
+
+  void reset() {
+    occ_ = 0;
+    hcoord_.fill(0);
+    vcoord_.fill(0);
+    hused_ = 0;
+    vused_ = 0;
+    pos_ = 0;
+    curnum_ = 1;
+  }
+
+  bool all() const { return occ_ == full(); }
+
+  bool tight() const {
+    return (hused_ == (uint64_t(1) << (N - 1)) - 1) &&
+           (vused_ == (uint64_t(1) << (M - 1)) - 1);
+  }
+
+  // cell where next block will be placed, row by row
+  size_t next_cell() const { return pos_; }
+
+  bool vtype() const {
+    assert(all() && tight());
+    assert(curnum_ - 1 == M + N - 1);
+    return cells_vtype(N, M, cells(), curnum_);
+  }
+
+  vector<size_t> vtype_signature() const {
+    return cells_vtype_signature(N, M, cells());
+  }
+
+  // vtype and signature (in vs.signature) in one pass
+  bool vtype_scan(vtype_scratch &vs) const {
+    assert(all() && tight());
+    return cells_vtype_scan(N, M, cells(), curnum_, vs);
+  }
+
+  void dump(ostream &os) const { cells_dump(os, N, M, cells()); }
+
+  // block numbers row by row
+  template <typename OutIt> void copy_cells(OutIt out) const {
+    auto fld = cells();
+    std::copy(fld.begin(), fld.begin() + N * M, out);
+  }
+
+  bool put(size_t hlen, size_t vlen) {
+    assert((hlen >= 1) && (vlen >= 1));
+    size_t hpos = pos_ % N;
+    size_t vpos = pos_ / N;
+
+    if (hpos + hlen > N)
+      return false;
+
+    if (vpos + vlen > M)
+      return false;
+
+    uint64_t mask = (((uint64_t(1) << hlen) - 1) * this->colmask(vlen))
+                    << pos_;
+    if (occ_ & mask)
+      return false;
+
+    occ_ |= mask;
+    blocks_[curnum_] = mask;
+    mark(hpos, vpos, hlen, vlen);
+    curnum_ += 1;
+    pos_ = first_free();
+    return true;
+  }
+
+  // put never leaves partial block behind, so push is just put
+  bool push(size_t hlen, size_t vlen) { return put(hlen, vlen); }
+
+  void pop() {
+    assert(curnum_ > 1);
+    curnum_ -= 1;
+    uint64_t mask = blocks_[curnum_];
+    occ_ &= ~mask;
+
+    // block starts at its lowest bit and ends at its highest bit
+    size_t first = __builtin_ctzll(mask);
+    size_t last = 63 - __builtin_clzll(mask);
+    size_t hpos = first % N;
+    size_t vpos = first / N;
+    unmark(hpos, vpos, last % N - hpos + 1, last / N - vpos + 1);
+    pos_ = first;
+  }
+};
+
+using BitField = BasicBitField<DynamicDims>;
+
+template <size_t N, size_t M>
+using FixedField = BasicBitField<StaticDims<N, M>>;
+
+#endif
@@ -0,0 +1,142 @@
+//------------------------------------------------------------------------------
+//
+//  Block types catalogue for N x M field
+//
+//------------------------------------------------------------------------------
+//
+// Possible blocks are (1 .. N-1) x (1 .. M-1) + N x 1 + 1 x M. Blocks of the
+// same area are variants of this area, say for 3x3 field
+//
+//  area 1: 1x1
+//  area 2: 1x2, 2x1
+//  area 3: 3x1, 1x3
+//  area 4: 2x2
+//
+// All variants are kept in one flat array, ordered by area, so types of area
+// a are types[offsets[a] .. offsets[a + 1]). No lookup, no allocation in
+// enumeration: both count(area) and at(area, variant) are two loads.
+//
+// FixedBlockTypes<N, M> is the same table, built at compile time.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// calls f(area, horz, vert) for every block type in catalogue order
+template <typename F>
+constexpr void for_each_btype(size_t N, size_t M, F &&f) {
+  f(N, N, 1);
+  f(M, 1, M);
+  for (size_t horz = 1; horz < N; ++horz)
+    for (size_t vert = 1; vert < M; ++vert)
+      f(horz * vert, horz, vert);
+}
+
+// std::pair assignment is not constexpr in C++17
+struct btype {
+  size_t horz, vert;
+};
+
+constexpr size_t btypes_maxarea(size_t N, size_t M) {
+  size_t inner = (N - 1) * (M - 1);
+  return (N > M) ? ((N > inner) ? N : inner) : ((M > inner) ? M : inner);
+}
+
+constexpr size_t btypes_count(size_t N, size_t M) {
+  return 2 + (N - 1) * (M - 1);
+}
+
+// fills offsets and types, which shall be of size maxarea + 2 and count
+template <typename Offs, typename Types>
+constexpr void btypes_fill(size_t N, size_t M, Offs &offsets, Types &types) {
+  for (auto &o : offsets)
+    o = 0;
+  for_each_btype(N, M, [&](size_t area, size_t, size_t) {
+    offsets[area + 1] += 1;
+  });
+  for (size_t area = 1; area < offsets.size(); ++area)
+    offsets[area] += offsets[area - 1];
+
+  // offsets[area] serves as insertion point, so it is shifted back after
+  for_each_btype(N, M, [&](size_t area, size_t horz, size_t vert) {
+    types[offsets[area]] = btype{horz, vert};
+    offsets[area] += 1;
+  });
+  for (size_t area = offsets.size() - 1; area > 0; --area)
+    offsets[area] = offsets[area - 1];
+  offsets[0] = 0;
+}
+
+class BlockTypes {
+  size_t maxarea_;
+  std::vector<size_t> offsets_;
+  std::vector<btype> types_;
+
+public:
+  BlockTypes(size_t N, size_t M)
+      : maxarea_(btypes_maxarea(N, M)), offsets_(maxarea_ + 2),
+        types_(btypes_count(N, M)) {
+    btypes_fill(N, M, offsets_, types_);
+  }
+
+  size_t maxarea() const { return maxarea_; }
+
+  // number of variants for given area
+  size_t count(size_t area) const {
+    if (area > maxarea_)
+      return 0;
+    return offsets_[area + 1] - offsets_[area];
+  }
+
+  // <horz, vert> of given variant
+  std::pair<size_t, size_t> at(size_t area, size_t variant) const {
+    assert(variant < count(area));
+    auto bt = types_[offsets_[area] + variant];
+    return {bt.horz, bt.vert};
+  }
+};
+
+template <size_t N, size_t M> struct fixed_btypes_table {
+  std::array<size_t, btypes_maxarea(N, M) + 2> offsets{};
+  std::array<btype, btypes_count(N, M)> types{};
+
+  constexpr fixed_btypes_table() { btypes_fill(N, M, offsets, types); }
+};
+
+// table itself is static constexpr, so for known area everything folds
+template <size_t N, size_t M> class FixedBlockTypes {
+  static constexpr size_t maxarea_ = btypes_maxarea(N, M);
+  static constexpr fixed_btypes_table<N, M> tbl_{};
+
+public:
+  constexpr FixedBlockTypes() = default;
+
+  // same constructor as for BlockTypes
+  FixedBlockTypes(size_t horz, size_t vert) {
+    assert((horz == N) && (vert == M));
+  }
+
+  static constexpr size_t maxarea() { return maxarea_; }
+
+  static constexpr size_t count(size_t area) {
+    if (area > maxarea_)
+      return 0;
+    return tbl_.offsets[area + 1] - tbl_.offsets[area];
+  }
+
+  static constexpr std::pair<size_t, size_t> at(size_t area, size_t variant) {
+    auto bt = tbl_.types[tbl_.offsets[area] + variant];
+    return {bt.horz, bt.vert};
+  }
+};
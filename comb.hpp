@@ -15,7 +15,31 @@
 // 0 2 3
 // ... etc ...
 //
-// Details may be found in Knuth, algorithm R from 7.2.1.3 (vol 4A)
+// Order is revolving door, so combinations with largest element c come
+// together, and inside them the rest goes in reversed order. So rank of
+// c_1 < c_2 < ... < c_t is
+//
+//  rank(c_1 .. c_t) = C(c_t + 1, t) - 1 - rank(c_1 .. c_{t-1})
+//
+// and unrank(k) finds c_t as largest c with C(c, t) <= k and goes on. With
+// split(parts) order is cut into contiguous slices, each slice is all_comb
+// on its own: it starts from its first combination and next_comb returns
+// false after its last one, so slices may be walked by different threads.
+//
+// Every step of revolving door removes one element and adds one, they are
+// out() and in(). So combinations as bitmasks go without any loop:
+//
+//  revolving_mask<uint64_t> rm(5, 3);    colex_mask<uint64_t> cm(5, 3);
+//  00111                                 00111
+//  01101   swapped bits 1 and 3          01011
+//  01110   swapped bits 0 and 1          01101
+//  ... etc ...                           ... etc ...
+//
+// colex_mask is Gosper's hack, colexicographic order, word may be any
+// unsigned integer type including __uint128_t.
+//
+// Details may be found in Knuth, algorithm R from 7.2.1.3 (vol 4A), Gosper's
+// hack is HAKMEM 175, see also 7.1.3 (vol 4A)
 //
 //------------------------------------------------------------------------------
 //
@@ -27,13 +51,44 @@
 #pragma once
 
 #include <cassert>
+#include <climits>
+#include <cstddef>
 #include <numeric>
+#include <stdexcept>
 #include <vector>
 
+// C(n, k), 0 if k > n
+inline size_t comb_binomial(int n, int k) {
+  if ((k < 0) || (k > n))
+    return 0;
+  size_t res = 1;
+  for (int i = 1; i <= k; ++i) {
+    // res * (n - k + i) / i is binomial itself, so division is exact
+    if (__builtin_mul_overflow(res, size_t(n - k + i), &res))
+      throw std::overflow_error("Binomial overflow");
+    res /= i;
+  }
+  return res;
+}
+
 class all_comb {
   std::vector<int> combination_;
   int total_;
 
+  // slice of revolving door order: first rank, length and number of steps
+  // left to its end; whole order ends by itself, so it has no length and
+  // C(n, t) is not needed, unless it is split
+  static constexpr size_t unlimited = static_cast<size_t>(-1);
+  size_t first_, size_, left_;
+
+  // element removed and element added by last step
+  int out_ = -1, in_ = -1;
+
+  all_comb(int n, int t, size_t first, size_t size)
+      : combination_(t + 1), total_(n), first_(first), size_(size) {
+    reinit();
+  }
+
 public:
   auto begin() { return combination_.begin(); }
   auto end() { return std::prev(combination_.end()); }
@@ -42,38 +97,109 @@ public:
     assert(n > 0 && "Makes no sense to combine things out of nothing");
     assert(t > 0 && "Makes no sense to combine zero number of things");
     assert(n > t && "Makes no sense to have n <= t");
+    first_ = 0;
+    size_ = unlimited;
     reinit();
   }
 
+  // back to the first combination of slice
   void reinit() {
-    std::iota(combination_.begin(), combination_.end(), 0);
+    if (first_ == 0) {
+      std::iota(combination_.begin(), combination_.end(), 0);
+      combination_.back() = total_;
+    } else
+      unrank(first_);
+    left_ = (size_ == unlimited) ? unlimited : size_ - 1;
+  }
+
+  // number of combinations of whole order, not of slice
+  size_t count() const {
+    return comb_binomial(total_, combination_.size() - 1);
+  }
+
+  size_t rank() const {
+    size_t res = 0;
+    for (size_t k = 1; k < combination_.size(); ++k)
+      res = comb_binomial(combination_[k - 1] + 1, k) - 1 - res;
+    return res;
+  }
+
+  // goes to combination of given rank in whole order
+  void unrank(size_t k) {
+    assert(k < count());
+    int c = total_;
+    for (int t = combination_.size() - 1; t > 0; --t) {
+      c -= 1;
+      while (comb_binomial(c, t) > k)
+        c -= 1;
+      combination_[t - 1] = c;
+      k = comb_binomial(c + 1, t) - 1 - k;
+    }
     combination_.back() = total_;
   }
 
+  // cuts this slice into parts of nearly equal sizes, empty ones omitted
+  std::vector<all_comb> split(size_t parts) const {
+    assert(parts > 0);
+    std::vector<all_comb> res;
+    size_t start = first_;
+    size_t total = (size_ == unlimited) ? count() : size_;
+    for (size_t p = 0; p < parts; ++p) {
+      size_t len = total / parts + ((p < total % parts) ? 1 : 0);
+      if (len == 0)
+        break;
+      res.push_back(all_comb(total_, combination_.size() - 1, start, len));
+      start += len;
+    }
+    return res;
+  }
+
+  // elements removed and added by last step of next_comb, which returned true
+  int out() const { return out_; }
+  int in() const { return in_; }
+
   bool next_comb() {
+    if (left_ == 0) {
+      reinit();
+      return false;
+    }
+    if (left_ != unlimited)
+      left_ -= 1;
+
     bool skipr4 = false;
     int comblen_ = combination_.size() - 1;
 
     if ((comblen_ % 2) == 1) {
       if (combination_[0] + 1 < combination_[1]) {
+        out_ = combination_[0];
         combination_[0] += 1;
+        in_ = combination_[0];
         return true;
       }
     } else {
       if (combination_[0] > 0) {
+        out_ = combination_[0];
         combination_[0] -= 1;
+        in_ = combination_[0];
         return true;
       }
       skipr4 = true;
     }
 
+    // for t = 1 there is nothing beyond c_1, c_2 is sentinel
     int j = 2;
+    if (j > comblen_) {
+      reinit();
+      return false;
+    }
 
     for (;;) {
       // step R4
       if (!skipr4) {
         assert(combination_[j - 1] == combination_[j - 2] + 1);
         if (combination_[j - 1] >= j) {
+          out_ = combination_[j - 1];
+          in_ = j - 2;
           combination_[j - 1] = combination_[j - 2];
           combination_[j - 2] = j - 2;
           break;
@@ -84,6 +210,8 @@ public:
       // step R5
       assert(combination_[j - 2] == j - 2);
       if (combination_[j - 1] + 1 < combination_[j]) {
+        out_ = j - 2;
+        in_ = combination_[j - 1] + 1;
         combination_[j - 2] = combination_[j - 1];
         combination_[j - 1] += 1;
         break;
@@ -99,3 +227,79 @@ public:
     return true;
   }
 };
+
+// helper: bitmask of combination [start, fin)
+template <typename W, typename It> W comb_mask(It start, It fin) {
+  W res = 0;
+  for (auto it = start; it != fin; ++it)
+    res |= W(1) << *it;
+  return res;
+}
+
+// revolving door order as bitmasks, mask is updated by one xor per step
+template <typename W> class revolving_mask {
+  all_comb ac_;
+  W mask_;
+
+  explicit revolving_mask(all_comb ac)
+      : ac_(ac), mask_(comb_mask<W>(ac_.begin(), ac_.end())) {}
+
+public:
+  revolving_mask(int n, int t) : revolving_mask(all_comb(n, t)) {
+    assert(n <= int(sizeof(W) * CHAR_BIT) && "Word is too short");
+  }
+
+  W mask() const { return mask_; }
+
+  // bits, swapped by last step
+  int out() const { return ac_.out(); }
+  int in() const { return ac_.in(); }
+
+  // slices, as for all_comb
+  std::vector<revolving_mask> split(size_t parts) const {
+    std::vector<revolving_mask> res;
+    for (auto &sl : ac_.split(parts))
+      res.push_back(revolving_mask(sl));
+    return res;
+  }
+
+  bool next_comb() {
+    if (!ac_.next_comb()) {
+      mask_ = comb_mask<W>(ac_.begin(), ac_.end());
+      return false;
+    }
+    mask_ ^= (W(1) << ac_.out()) | (W(1) << ac_.in());
+    return true;
+  }
+};
+
+// colexicographic order as bitmasks: 0 < t <= n
+template <typename W> class colex_mask {
+  W first_, last_, mask_;
+
+public:
+  colex_mask(int n, int t)
+      : first_((t < int(sizeof(W) * CHAR_BIT)) ? (W(1) << t) - 1 : ~W(0)),
+        last_(first_ << (n - t)), mask_(first_) {
+    assert(t > 0 && "Makes no sense to combine zero number of things");
+    assert(n >= t && "Makes no sense to have n < t");
+    assert(n <= int(sizeof(W) * CHAR_BIT) && "Word is too short");
+  }
+
+  W mask() const { return mask_; }
+
+  void reinit() { mask_ = first_; }
+
+  bool next_comb() {
+    if (mask_ == last_) {
+      reinit();
+      return false;
+    }
+
+    // lowest run of ones: its top bit goes one up, rest goes down
+    W low = mask_ & -mask_;
+    W ripple = mask_ + low;
+    mask_ = (((ripple ^ mask_) >> 2) / low) | ripple;
+    return true;
+  }
+};
@@ -1,9 +1,67 @@
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <vector>
 
 #include "comb.hpp"
 
+// rank shall count next_comb steps, unrank shall invert it and slices
+// shall be the same walk, cut into pieces
+void test_rank(int n, int t) {
+  all_comb ac(n, t), other(n, t);
+  std::vector<std::vector<int>> all;
+  do {
+    assert(ac.rank() == all.size());
+    other.unrank(all.size());
+    assert(std::equal(ac.begin(), ac.end(), other.begin()));
+    all.emplace_back(ac.begin(), ac.end());
+  } while (ac.next_comb());
+  assert(all.size() == ac.count());
+
+  for (size_t parts = 1; parts <= all.size() + 2; parts += 3) {
+    size_t idx = 0;
+    for (auto &sl : ac.split(parts)) {
+      do {
+        assert(std::equal(sl.begin(), sl.end(), all[idx].begin()));
+        idx += 1;
+      } while (sl.next_comb());
+      // slice wraps to its own start
+      assert(std::equal(sl.begin(), sl.end(), all[sl.rank()].begin()));
+    }
+    assert(idx == all.size());
+  }
+}
+
+// masks shall be the same walk as all_comb and all masks of t bits in
+// increasing order
+void test_masks(int n, int t) {
+  all_comb ac(n, t);
+  revolving_mask<uint64_t> rm(n, t);
+  bool more;
+  do {
+    assert(rm.mask() == comb_mask<uint64_t>(ac.begin(), ac.end()));
+    uint64_t prev = rm.mask();
+    more = ac.next_comb();
+    assert(rm.next_comb() == more);
+    if (more)
+      assert((prev ^ rm.mask()) == ((uint64_t(1) << rm.out()) |
+                                    (uint64_t(1) << rm.in())));
+  } while (more);
+  assert(rm.mask() == comb_mask<uint64_t>(ac.begin(), ac.end()));
+
+  colex_mask<uint64_t> cm(n, t);
+  size_t cnt = 0;
+  for (uint64_t m = 0; m < (uint64_t(1) << n); ++m) {
+    if (__builtin_popcountll(m) != t)
+      continue;
+    assert(cm.mask() == m);
+    cnt += 1;
+    assert(cm.next_comb() == (cnt < comb_binomial(n, t)));
+  }
+  assert(cm.mask() == (uint64_t(1) << t) - 1);
+}
+
 int main() {
   int n = 5;
   int t = 3;
@@ -22,4 +80,37 @@ int main() {
       std::cout << *it << " ";
     std::cout << std::endl;
   } while (ac.next_comb());
-}
\ No newline at end of file
+
+  for (int n = 2; n <= 10; ++n)
+    for (int t = 1; t < n; ++t)
+      test_rank(n, t);
+
+  for (int n = 2; n <= 12; ++n)
+    for (int t = 1; t < n; ++t)
+      test_masks(n, t);
+
+  // whole order does not need C(n, t), so it may be too large for size_t
+  all_comb huge(80, 40);
+  for (int step = 0; step < 1000; ++step)
+    assert(huge.next_comb());
+
+  // words of 64 and 128 bits up to the top bit
+  colex_mask<uint64_t> full(64, 64);
+  assert((full.mask() == ~uint64_t(0)) && !full.next_comb());
+
+  colex_mask<__uint128_t> wide(128, 2);
+  size_t cnt = 1;
+  while (wide.next_comb())
+    cnt += 1;
+  assert(cnt == comb_binomial(128, 2));
+
+  revolving_mask<__uint128_t> rwide(100, 3);
+  __uint128_t top = __uint128_t(1) << 99;
+  size_t withtop = 0;
+  cnt = 0;
+  do {
+    cnt += 1;
+    withtop += ((rwide.mask() & top) != 0);
+  } while (rwide.next_comb());
+  assert(cnt == comb_binomial(100, 3) && withtop == comb_binomial(99, 2));
+}
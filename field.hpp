@@ -53,18 +53,121 @@
 #ifndef FIELD_GUARD_
 #define FIELD_GUARD_
 
-#include <iostream>
+#include <algorithm>
 #include <cassert>
+#include <iostream>
 #include <vector>
 
 using std::fill;
-using std::find_if;
 using std::ostream;
 using std::vector;
 
-template <typename V> static inline bool all_set(V x) {
-  return (x.end() ==
-          find_if(x.begin(), x.end(), [](size_t b) { return (b == 0); }));
+// Cell-level checks, shared by all field representations
+// fld keeps block numbers row by row, like 11111|22222|...
+//
+// Easiest way to determine vtype is to use vertical lengths of current num
+//
+// 1 2 2 2 3
+// 1 4 5 6 3
+// 1 4 5 7 3
+//
+// is tight paving but not a vtype, because it has on level 2
+// adjacent curnums 4 and 5  with same vlen and vends
+//
+// but
+//
+// 1 2 2 2 3
+// 1 4 5 6 3
+// 1 4 7 6 3
+//
+// is a vtype.
+//
+// Btw, it is one of six proper 5x3 vtypes, others five are:
+// 12345|16345|16375
+// 12345|12645|17775
+// 12345|12365|17365
+// 12334|12564|17764
+// 12234|15634|15774
+//
+// Blocks are rectangles, so same vlen and vend is the same as same top and
+// bottom rows. In one pass over cells, every block gets its bottom row when
+// its top left cell is met (walking down its own cells only) and is
+// compared with its left neighbour, which is already known. Signature is
+// counted in the same pass by changes down each column, it is complete only
+// if paving is vtype, because scan stops at first failure.
+//
+// Buffers are passed in and reused, so there is no allocation per paving.
+struct vtype_scratch {
+  vector<size_t> first;
+  vector<size_t> bottom;
+  vector<size_t> signature;
+};
+
+template <typename C>
+bool cells_vtype_scan(size_t N, size_t M, const C &fld_, size_t curnum_,
+                      vtype_scratch &vs) {
+  vs.first.assign(curnum_, M * N);
+  vs.bottom.resize(curnum_);
+  vs.signature.assign(N, 1);
+
+  // plain pointers, so compiler does not reload vector internals after
+  // every store to scratch
+  size_t *first = vs.first.data();
+  size_t *bottom = vs.bottom.data();
+  size_t *sig = vs.signature.data();
+
+  for (size_t y = 0; y < M; ++y)
+    for (size_t x = 0; x < N; ++x) {
+      auto cur = y * N + x;
+      auto ncur = fld_[cur];
+      if ((y > 0) && (fld_[cur - N] != ncur))
+        sig[x] += 1;
+      if (first[ncur] != M * N)
+        continue;
+
+      size_t last = y;
+      while ((last + 1 < M) && (fld_[cur + (last + 1 - y) * N] == ncur))
+        last += 1;
+      first[ncur] = cur;
+      bottom[ncur] = last;
+
+      if (x > 0) {
+        auto nprev = fld_[cur - 1];
+        assert(ncur != nprev);
+        if ((first[nprev] / N == y) && (bottom[nprev] == last))
+          return false;
+      }
+    }
+  return true;
+}
+
+template <typename C>
+bool cells_vtype(size_t N, size_t M, const C &fld_, size_t curnum_) {
+  thread_local vtype_scratch vs;
+  return cells_vtype_scan(N, M, fld_, curnum_, vs);
+}
+
+template <typename C>
+vector<size_t> cells_vtype_signature(size_t N, size_t M, const C &fld_) {
+  vector<size_t> retval(N);
+  for (size_t x = 0; x < N; ++x) {
+    size_t next = 1;
+    for (size_t y = 1; y < M; ++y) 
+      if (fld_[y*N + x] != fld_[(y-1)*N + x])
+        next += 1;
+    retval[x] = next;
+  }
+  return retval;
+}
+
+template <typename C>
+void cells_dump(ostream &os, size_t N, size_t M, const C &fld_) {
+  for (size_t x = 0; x < M; ++x) {
+    for (size_t y = 0; y < N; ++y)
+      os << static_cast<size_t>(fld_[x * N + y]);
+    if (x != M - 1)
+      os << "|";
+  }
 }
 
 class Field {
@@ -77,6 +180,18 @@ class Field {
   size_t hpos_ = 0;
   size_t curnum_ = 1;
 
+  // running counters, so all() and tight() are O(1): number of occupied
+  // cells and number of coordinate lines, not used by any block edge
+  size_t filled_ = 0;
+  size_t hzero_;
+  size_t vzero_;
+
+  // undo record for push/pop: where block was started and its sizes
+  struct placement {
+    size_t hpos, vpos, hlen, vlen;
+  };
+  vector<placement> undo_;
+
   // helper: promote vpos_ and hpos_ to unoccupied
   // returns n of promoted cells
   size_t promote() {
@@ -104,6 +219,7 @@ class Field {
       if (fld_[vpos_ * N + hpos_ + idx] > 0)
         return false;
       fld_[vpos_ * N + hpos_ + idx] = num;
+      filled_ += 1;
     }
 
     promote();
@@ -125,6 +241,7 @@ class Field {
       if (fld_[(vpos_ + idx) * N + hpos_] > 0)
         return false;
       fld_[(vpos_ + idx) * N + hpos_] = num;
+      filled_ += 1;
     }
 
     size_t np = promote();
@@ -135,9 +252,33 @@ class Field {
     return true;
   }
 
+  // helper: wipe cells of block num from rectangle, started at pl
+  // failed put may leave only part of rectangle written
+  void erase(placement pl, size_t num) {
+    for (size_t y = pl.vpos; y != pl.vpos + pl.vlen; ++y)
+      for (size_t x = pl.hpos; x != pl.hpos + pl.hlen; ++x)
+        if (fld_[y * N + x] == num) {
+          fld_[y * N + x] = 0;
+          filled_ -= 1;
+        }
+  }
+
+  // helpers: block edge on coordinate line added or removed
+  static void use_line(vector<size_t> &coord, size_t line, size_t &nzero) {
+    if (coord[line]++ == 0)
+      nzero -= 1;
+  }
+
+  static void unuse_line(vector<size_t> &coord, size_t line, size_t &nzero) {
+    if (--coord[line] == 0)
+      nzero += 1;
+  }
+
 public:
   Field(size_t horz, size_t vert)
-      : N(horz), M(vert), fld_(M * N, 0), hcoord_(N - 1, 0), vcoord_(M - 1, 0) {
+      : N(horz), M(vert), fld_(M * N, 0), hcoord_(N - 1, 0), vcoord_(M - 1, 0),
+        hzero_(N - 1), vzero_(M - 1) {
+    undo_.reserve(M + N);
   }
 
   void reset() {
@@ -147,82 +288,40 @@ public:
     hpos_ = 0;
     vpos_ = 0;
     curnum_ = 1;
+    filled_ = 0;
+    hzero_ = N - 1;
+    vzero_ = M - 1;
+    undo_.clear();
   }
 
-  bool all() { return all_set(fld_); }
+  bool all() const { return filled_ == M * N; }
 
-  bool tight() { return all_set(hcoord_) && all_set(vcoord_); }
+  bool tight() const { return (hzero_ == 0) && (vzero_ == 0); }
+
+  // cell where next block will be placed, row by row
+  size_t next_cell() const { return vpos_ * N + hpos_; }
 
-  // Easiest way to determine vtype is to use vertical lengths of current num
-  //
-  // 1 2 2 2 3
-  // 1 4 5 6 3
-  // 1 4 5 7 3
-  //
-  // is tight paving but not a vtype, because it has on level 2
-  // adjacent curnums 4 and 5  with same vlen and vends
-  //
-  // but
-  //
-  // 1 2 2 2 3
-  // 1 4 5 6 3
-  // 1 4 7 6 3
-  //
-  // is a vtype.
-  //
-  // Btw, it is one of six proper 5x3 vtypes, others five are:
-  // 12345|16345|16375
-  // 12345|12645|17775
-  // 12345|12365|17365
-  // 12334|12564|17764
-  // 12234|15634|15774
-  //
   bool vtype() {
     assert(all() && tight());
     assert(curnum_ - 1 == M + N - 1);
-    vector<size_t> vlens(curnum_, 0);
-    vector<size_t> vends(curnum_, 0);
-    for (size_t y = 0; y < M; ++y)
-      for (size_t x = 0; x < N; ++x) {
-        auto cur = y * N + x;
-        auto ncur = fld_[cur];
-        if (vlens[ncur] == 0) {
-          for (size_t test = 0; test < M; ++test) {
-            if (ncur == fld_[test * N + x]) {
-              vlens[ncur] += 1;
-              vends[ncur] = test;
-            }
-          }
-          if (x > 0) {
-            auto nprev = fld_[cur - 1];
-            assert(ncur != nprev);
-            if ((vlens[ncur] == vlens[nprev]) && (vends[ncur] == vends[nprev]))
-              return false;
-          }
-        }
-      }
-    return true;
+    return cells_vtype(N, M, fld_, curnum_);
   }
 
   vector<size_t> vtype_signature() {
-    vector<size_t> retval(N);
-    for (size_t x = 0; x < N; ++x) {
-      size_t next = 1;
-      for (size_t y = 1; y < M; ++y) 
-        if (fld_[y*N + x] != fld_[(y-1)*N + x])
-          next += 1;
-      retval[x] = next;
-    }
-    return retval;
+    return cells_vtype_signature(N, M, fld_);
   }
 
-  void dump(ostream &os) {
-    for (size_t x = 0; x < M; ++x) {
-      for (size_t y = 0; y < N; ++y)
-        os << fld_[x * N + y];
-      if (x != M - 1)
-        os << "|";
-    }
+  // vtype and signature (in vs.signature) in one pass
+  bool vtype_scan(vtype_scratch &vs) const {
+    assert(all() && tight());
+    return cells_vtype_scan(N, M, fld_, curnum_, vs);
+  }
+
+  void dump(ostream &os) { cells_dump(os, N, M, fld_); }
+
+  // block numbers row by row
+  template <typename OutIt> void copy_cells(OutIt out) const {
+    std::copy(fld_.begin(), fld_.end(), out);
   }
 
   bool put(size_t hlen, size_t vlen) {
@@ -242,7 +341,7 @@ public:
       if (!res)
         return false;
     } else {
-      for (int idx = 0; idx != hlen; ++idx) {
+      for (size_t idx = 0; idx != hlen; ++idx) {
         res = put_vert(vlen, curnum_, (idx != hlen - 1));
         if (!res)
           return false;
@@ -250,14 +349,54 @@ public:
     }
 
     if (oldhpos + hlen < N)
-      hcoord_[oldhpos + hlen - 1] += 1;
+      use_line(hcoord_, oldhpos + hlen - 1, hzero_);
 
     if (oldvpos + vlen < M)
-      vcoord_[oldvpos + vlen - 1] += 1;
+      use_line(vcoord_, oldvpos + vlen - 1, vzero_);
 
     curnum_ += 1;
     return res;
   }
+
+  // backtracking interface: push is put, which leaves field unchanged on
+  // failure, and pop undoes last successful push
+  //
+  // f.push(3, 1);  // 111x
+  // f.push(1, 2);  // 1112
+  //                // x--2
+  // f.pop();       // 111x
+  //
+  bool push(size_t hlen, size_t vlen) {
+    placement pl{hpos_, vpos_, hlen, vlen};
+    if (put(hlen, vlen)) {
+      undo_.push_back(pl);
+      return true;
+    }
+
+    // put checks bounds before it writes anything
+    if ((pl.hpos + hlen <= N) && (pl.vpos + vlen <= M))
+      erase(pl, curnum_);
+    hpos_ = pl.hpos;
+    vpos_ = pl.vpos;
+    return false;
+  }
+
+  void pop() {
+    assert(!undo_.empty());
+    placement pl = undo_.back();
+    undo_.pop_back();
+    curnum_ -= 1;
+    erase(pl, curnum_);
+
+    if (pl.hpos + pl.hlen < N)
+      unuse_line(hcoord_, pl.hpos + pl.hlen - 1, hzero_);
+
+    if (pl.vpos + pl.vlen < M)
+      unuse_line(vcoord_, pl.vpos + pl.vlen - 1, vzero_);
+
+    hpos_ = pl.hpos;
+    vpos_ = pl.vpos;
+  }
 };
 
 #endif
@@ -1,7 +1,10 @@
+#include <sstream>
+
+#include "bitfield.hpp"
 #include "field.hpp"
 
-int test_field() {
-  Field f(4, 3);
+template <typename F> void test_field() {
+  F f(4, 3);
   assert(f.put(3, 1));
   assert(!f.put(3, 1));
   f.reset();
@@ -23,7 +26,7 @@ int test_field() {
   assert(f.all());
   assert(!f.tight());
 
-  Field fvert(3, 4);
+  F fvert(3, 4);
   assert(fvert.put(1, 2));
   assert(fvert.put(1, 1));
   assert(fvert.put(1, 3));
@@ -34,7 +37,7 @@ int test_field() {
   assert(fvert.all());
   assert(fvert.tight());
 
-  Field f2(3, 3);
+  F f2(3, 3);
   assert(f2.put(1, 1));
   assert(f2.put(1, 1));
   assert(f2.put(1, 1));
@@ -53,4 +56,74 @@ int test_field() {
   assert(!f2.put(2, 2));
 }
 
-int main() { test_field(); }
+template <typename F> void test_backtrack() {
+  F f(3, 3);
+  assert(f.push(1, 1));
+  assert(f.push(1, 2));
+  assert(f.push(1, 1));
+  assert(!f.push(2, 1));
+  assert(!f.push(1, 3));
+  assert(f.push(1, 1));
+  assert(f.push(1, 2));
+  assert(!f.all());
+  assert(f.push(2, 1));
+  assert(f.all());
+  assert(f.tight());
+  f.pop();
+  f.pop();
+  f.pop();
+  assert(!f.all());
+  assert(!f.push(2, 2));
+  assert(f.push(1, 2));
+  assert(f.push(1, 2));
+  assert(f.push(1, 1));
+  assert(f.all());
+  assert(f.tight());
+  for (int i = 0; i != 6; ++i)
+    f.pop();
+  assert(f.push(3, 1));
+  assert(f.push(3, 1));
+  assert(f.push(3, 1));
+  assert(f.all());
+  assert(!f.tight());
+}
+
+template <typename F> void test_vtype() {
+  F f(5, 3);
+  assert(f.push(1, 3));
+  assert(f.push(3, 1));
+  assert(f.push(1, 3));
+  assert(f.push(1, 2));
+  assert(f.push(1, 1));
+  assert(f.push(1, 2));
+  assert(f.push(1, 1));
+  assert(f.all());
+  assert(f.tight());
+  assert(f.vtype());
+  assert((f.vtype_signature() == vector<size_t>{1, 2, 3, 2, 1}));
+
+  std::ostringstream os;
+  f.dump(os);
+  assert(os.str() == "12223|14563|14763");
+
+  f.pop();
+  f.pop();
+  f.pop();
+  assert(f.push(1, 2));
+  assert(f.push(1, 1));
+  assert(f.push(1, 1));
+  assert(f.all());
+  assert(f.tight());
+  assert(!f.vtype());
+}
+
+int main() {
+  test_field<Field>();
+  test_backtrack<Field>();
+  test_vtype<Field>();
+  test_field<BitField>();
+  test_backtrack<BitField>();
+  test_vtype<BitField>();
+  test_backtrack<FixedField<3, 3>>();
+  test_vtype<FixedField<5, 3>>();
+}
@@ -6,6 +6,11 @@
 // This file implements next_break_of(n, m, begin, end) step
 // just like std::next_permuitation do so for permutations
 //
+// Also rank_break_of and unrank_break_of give random access to the same
+// sequence of partitions, so work may be split without serial walk,
+// BreakBatcher writes partitions by blocks into flat buffer and
+// RestrictedBreaks visits only partitions with allowed parts
+//
 //------------------------------------------------------------------------------
 //
 // This file is licensed after LGPL v3
@@ -15,7 +20,11 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cassert>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
 
 template <typename Iter>
 bool next_break_of(size_t n, size_t m, Iter start, Iter end) {
@@ -59,3 +68,246 @@ bool next_break_of(size_t n, size_t m, Iter start, Iter end) {
   last = s;
   return true;
 }
+
+// next_break_of visits partitions as non-decreasing sequences in
+// lexicographic order, say for n = 9, m = 5
+//
+//  0: 1 1 1 1 5
+//  1: 1 1 1 2 4
+//  2: 1 1 1 3 3
+//  3: 1 1 2 2 3
+//  4: 1 2 2 2 2
+//
+// Non-decreasing sequences of length k with sum s and all parts >= v are
+// partitions of s - k * (v - 1) into exactly k parts. So with a[0 .. i-1]
+// fixed, number of sequences with smaller a[i] is
+//
+//  tail(s, k, a[i - 1]) - tail(s, k, a[i])
+//
+// where s and k are sum and length of a[i .. m-1].
+//
+// Partition numbers p(n, k) = p(n - 1, k - 1) + p(n - k, k) are kept in
+// per-thread table, which only grows, so every call after first one is
+// O(m) for rank and O(n * m) for unrank. Entries too large for size_t are
+// saturated in table and only asking for them throws.
+
+// number of partitions of n into exactly k parts
+inline size_t break_count(size_t n, size_t k) {
+  constexpr size_t saturated = static_cast<size_t>(-1);
+  thread_local std::vector<std::vector<size_t>> tbl;
+  if (k > n)
+    return 0;
+
+  // new table is built aside, so old one is never left half-done
+  if ((n >= tbl.size()) || (k >= tbl[n].size())) {
+    size_t maxn = std::max(n + 1, tbl.size());
+    size_t maxk = std::max(k + 1, tbl.empty() ? 0 : tbl[0].size());
+    std::vector<std::vector<size_t>> t(maxn, std::vector<size_t>(maxk, 0));
+    t[0][0] = 1;
+    for (size_t nn = 1; nn < maxn; ++nn)
+      for (size_t kk = 1; (kk <= nn) && (kk < maxk); ++kk)
+        if (__builtin_add_overflow(t[nn - 1][kk - 1], t[nn - kk][kk],
+                                   &t[nn][kk]))
+          t[nn][kk] = saturated;
+    tbl.swap(t);
+  }
+
+  if (tbl[n][k] == saturated)
+    throw std::overflow_error("Too many partitions to rank");
+  return tbl[n][k];
+}
+
+// helper: number of non-decreasing sequences of length k with sum s and all
+// parts >= v
+inline size_t break_tail(size_t s, size_t k, size_t v) {
+  if (k == 0)
+    return (s == 0) ? 1 : 0;
+  if (k * (v - 1) > s)
+    return 0;
+  return break_count(s - k * (v - 1), k);
+}
+
+// number of partitions, visited by next_break_of(n, m, ...)
+inline size_t count_breaks_of(size_t n, size_t m) { return break_count(n, m); }
+
+// position of partition [start, end) in next_break_of order
+template <typename Iter>
+size_t rank_break_of(size_t n, size_t m, Iter start, Iter end) {
+  size_t res = 0, prev = 1, s = n, k = m;
+  for (; start != end; ++start, --k) {
+    assert(k > 0);
+    assert(*start >= prev);
+    res += break_tail(s, k, prev) - break_tail(s, k, *start);
+    prev = *start;
+    s -= *start;
+  }
+  assert((k == 0) && (s == 0));
+  return res;
+}
+
+// fill [start, end) with partition number rank in next_break_of order
+template <typename Iter>
+void unrank_break_of(size_t n, size_t m, size_t rank, Iter start, Iter end) {
+  assert(rank < count_breaks_of(n, m));
+  size_t prev = 1, s = n, k = m;
+  for (; start != end; ++start, --k) {
+    assert(k > 0);
+    size_t v = prev;
+    for (;;) {
+      size_t c = break_tail(s, k, v) - break_tail(s, k, v + 1);
+      if (rank < c)
+        break;
+      rank -= c;
+      v += 1;
+    }
+    *start = v;
+    prev = v;
+    s -= v;
+  }
+  assert(k == 0);
+}
+
+// Batches of consecutive partitions in flat m-strided buffer: partition j
+// of batch is buf[j * m .. j * m + m). Say for n = 9, m = 5 and k = 2
+//
+//  BreakBatcher bb(9, 5);
+//  bb.fill(buf, 2);  // 1 1 1 1 5 1 1 1 2 4, returns 2
+//  bb.fill(buf, 2);  // 1 1 1 3 3 1 1 2 2 3, returns 2
+//  bb.fill(buf, 2);  // 1 2 2 2 2, returns 1
+//  bb.fill(buf, 2);  // returns 0
+//
+// so consumer may filter whole batch over contiguous memory
+class BreakBatcher {
+  size_t n_, m_;
+  std::vector<size_t> cur_;
+  bool done_ = false;
+
+public:
+  // starts from first partition 1, 1, ..., n - m + 1
+  BreakBatcher(size_t n, size_t m) : n_(n), m_(m), cur_(m, 1) {
+    cur_[m - 1] = n - m + 1;
+  }
+
+  // starts from given partition
+  template <typename Iter>
+  BreakBatcher(size_t n, size_t m, Iter start, Iter end)
+      : n_(n), m_(m), cur_(start, end) {
+    assert(cur_.size() == m);
+  }
+
+  // starts from partition with given rank
+  BreakBatcher(size_t n, size_t m, size_t rank) : n_(n), m_(m), cur_(m) {
+    unrank_break_of(n, m, rank, cur_.begin(), cur_.end());
+  }
+
+  bool done() const { return done_; }
+
+  // writes up to k partitions, returns number written
+  template <typename OutIt> size_t fill(OutIt buf, size_t k) {
+    size_t cnt = 0;
+    for (; !done_ && (cnt < k); ++cnt) {
+      buf = std::copy(cur_.begin(), cur_.end(), buf);
+      done_ = !next_break_of(n_, m_, cur_.begin(), cur_.end());
+    }
+    return cnt;
+  }
+};
+
+// Partitions with parts only from allowed set, in the same order as
+// next_break_of. Say for n = 9, m = 5 and parts 1, 2, 4 only
+//
+//  1 1 1 2 4
+//  1 2 2 2 2
+//
+// Next partition is found directly: rightmost part, which may be increased
+// to next allowed value, is increased and tail is filled with smallest
+// possible completion. Forbidden prefixes are never visited at all.
+//
+// Completion exists iff feasible(k, s, lo): there is non-decreasing
+// sequence of k allowed parts, all >= lo, with sum s. It is precomputed
+// for all k <= m, s <= n, lo <= n + 1 from
+//
+//  F(k, s, lo) = (lo allowed && F(k - 1, s - lo, lo)) || F(k, s, lo + 1)
+//
+// so step is O(n * m) in the worst case.
+class RestrictedBreaks {
+  size_t n_, m_;
+  std::vector<unsigned char> allowed_;
+  std::vector<unsigned char> feas_;
+
+  bool feasible(size_t k, size_t s, size_t lo) const {
+    return feas_[(k * (n_ + 1) + s) * (n_ + 2) + lo];
+  }
+
+  // helper: smallest allowed v >= lo, which leaves completion for k - 1
+  // parts of s - v, or 0 if none
+  size_t smallest(size_t k, size_t s, size_t lo) const {
+    for (size_t v = lo; v * k <= s; ++v)
+      if (allowed_[v] && feasible(k - 1, s - v, v))
+        return v;
+    return 0;
+  }
+
+  // helper: fill [start + idx, start + m) with smallest completion
+  template <typename Iter>
+  void complete(Iter start, size_t idx, size_t s, size_t lo) const {
+    for (; idx < m_; ++idx) {
+      size_t v = smallest(m_ - idx, s, lo);
+      assert(v != 0);
+      start[idx] = v;
+      s -= v;
+      lo = v;
+    }
+  }
+
+public:
+  // allowed[v] tells if v is allowed part, for v = 1 .. n
+  template <typename Table>
+  RestrictedBreaks(size_t n, size_t m, const Table &allowed)
+      : n_(n), m_(m), allowed_(n + 2, 0),
+        feas_((m + 1) * (n + 1) * (n + 2), 0) {
+    assert(m >= 1 && m <= n);
+    for (size_t v = 1; v <= n; ++v)
+      allowed_[v] = allowed[v] ? 1 : 0;
+
+    for (size_t lo = 0; lo <= n + 1; ++lo)
+      feas_[lo] = 1; // k = 0, s = 0
+    for (size_t k = 1; k <= m; ++k)
+      for (size_t s = 0; s <= n; ++s) {
+        unsigned char *row = &feas_[(k * (n + 1) + s) * (n + 2)];
+        for (size_t lo = n + 1; lo-- > 0;)
+          row[lo] = row[lo + 1] || (allowed_[lo] && (lo <= s) &&
+                                    feasible(k - 1, s - lo, lo));
+      }
+  }
+
+  // smallest partition, false if there is no partitions at all
+  template <typename Iter> bool first(Iter start, Iter end) const {
+    assert(size_t(end - start) == m_);
+    if (!feasible(m_, n_, 1))
+      return false;
+    complete(start, 0, n_, 1);
+    return true;
+  }
+
+  // next partition after [start, end), which shall be allowed one
+  template <typename Iter> bool next(Iter start, Iter end) const {
+    assert(size_t(end - start) == m_);
+    size_t prefix = 0;
+    for (size_t idx = 0; idx + 1 < m_; ++idx)
+      prefix += start[idx];
+
+    // last part is fixed by the others, so start from one before it
+    for (size_t idx = m_ - 1; idx-- > 0;) {
+      prefix -= start[idx];
+      size_t s = n_ - prefix;
+      size_t v = smallest(m_ - idx, s, start[idx] + 1);
+      if (v == 0)
+        continue;
+      start[idx] = v;
+      complete(start, idx + 1, s - v, v);
+      return true;
+    }
+    return false;
+  }
+};
@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <stdexcept>
+#include <vector>
+
+#include "hind.hpp"
+
+// rank and unrank shall agree with next_break_of walk
+void test_rank(size_t n, size_t m) {
+  std::vector<size_t> a(m, 1), b(m);
+  a[m - 1] = n - m + 1;
+  size_t idx = 0;
+  do {
+    assert(rank_break_of(n, m, a.begin(), a.end()) == idx);
+    unrank_break_of(n, m, idx, b.begin(), b.end());
+    assert(a == b);
+    idx += 1;
+  } while (next_break_of(n, m, a.begin(), a.end()));
+  assert(idx == count_breaks_of(n, m));
+}
+
+// batches shall be the same walk, cut into pieces
+void test_batch(size_t n, size_t m, size_t k) {
+  std::vector<size_t> a(m, 1), buf(k * m);
+  a[m - 1] = n - m + 1;
+  BreakBatcher bb(n, m);
+  size_t total = 0;
+  while (size_t cnt = bb.fill(buf.begin(), k)) {
+    assert(cnt <= k);
+    for (size_t j = 0; j < cnt; ++j) {
+      assert(std::equal(a.begin(), a.end(), buf.begin() + j * m));
+      next_break_of(n, m, a.begin(), a.end());
+    }
+    total += cnt;
+  }
+  assert(bb.done());
+  assert(total == count_breaks_of(n, m));
+
+  // starting from rank gives tail of the same walk
+  size_t rank = total / 3;
+  BreakBatcher tail(n, m, rank);
+  size_t rest = 0;
+  while (size_t cnt = tail.fill(buf.begin(), k))
+    rest += cnt;
+  assert(rest == total - rank);
+}
+
+// restricted walk shall be next_break_of walk with disallowed parts
+// filtered out, mask tells allowed parts up to 16
+void test_restricted(size_t n, size_t m, unsigned mask) {
+  std::vector<unsigned char> allowed(n + 1);
+  for (size_t v = 1; v <= n; ++v)
+    allowed[v] = (v > 16) || ((mask >> (v - 1)) & 1);
+
+  RestrictedBreaks rb(n, m, allowed);
+  std::vector<size_t> a(m, 1), b(m);
+  a[m - 1] = n - m + 1;
+  bool more = rb.first(b.begin(), b.end());
+  do {
+    if (!std::all_of(a.begin(), a.end(), [&](size_t v) { return allowed[v]; }))
+      continue;
+    assert(more && (a == b));
+    more = rb.next(b.begin(), b.end());
+  } while (next_break_of(n, m, a.begin(), a.end()));
+  assert(!more);
+}
+
+int main() {
+  for (size_t n = 2; n <= 24; ++n)
+    for (size_t m = 2; m <= n; ++m)
+      test_rank(n, m);
+
+  for (size_t k = 1; k <= 7; ++k)
+    test_batch(20, 6, k);
+
+  for (unsigned mask = 0; mask < (1u << 8); ++mask)
+    for (size_t m = 2; m <= 6; ++m)
+      test_restricted(16, m, mask);
+  test_restricted(24, 7, 0xb9);
+
+  // jump into the middle of large sequence and go on from there
+  size_t n = 100, m = 10;
+  std::vector<size_t> a(m);
+  size_t mid = count_breaks_of(n, m) / 2;
+  unrank_break_of(n, m, mid, a.begin(), a.end());
+  for (size_t idx = 0; idx < 1000; ++idx) {
+    assert(rank_break_of(n, m, a.begin(), a.end()) == mid + idx);
+    assert(next_break_of(n, m, a.begin(), a.end()));
+  }
+
+  // table for large n has saturated entries, but only they are errors
+  assert(break_count(600, 300) == 9253082936723602ull);
+  bool thrown = false;
+  try {
+    break_count(600, 100);
+  } catch (std::overflow_error &) {
+    thrown = true;
+  }
+  assert(thrown);
+  assert(break_count(590, 250) == 144117936118835456ull);
+
+  std::cout << "partitions of 100 into 10 parts: " << count_breaks_of(n, m)
+            << std::endl;
+}
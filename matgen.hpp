@@ -8,7 +8,36 @@
 // Latter emulates virtually everything: independent sets, bases, circuits,
 // closed sets, hyperplanes, etc...
 //
-// Set of domain elements is to be better emulated by number
+// Set of domain elements is to be better emulated by number. Number type
+// is chosen by domain size (DomT::fin):
+//
+//   up to 32 elements  -- unsigned
+//   up to 64 elements  -- uint64_t
+//   up to 128 elements -- __uint128_t
+//   more               -- WideWord<K>, K 64-bit words, all operations are
+//                         plain loops over words, which are vectorized
+//
+// Set of sets is kept in StoreT with std::set-like interface:
+//
+//   FlatSet<BST>  -- sorted vector, inserts are appended and sorted in bulk
+//                    at the end of every change of SubSets (default)
+//   std::set<BST> -- node per set
+//
+// Both are iterated in increasing order of masks, so results are the same.
+//
+// Query "is there a set, containing X" goes to set-trie: every set is path
+// of its elements in increasing order, say for {01, 023, 13}
+//
+//   root -- 0 -- 1
+//        |    `- 2 -- 3
+//        `- 1 -- 3
+//
+// and X is matched along paths, going only to children not greater than
+// next element of X and only to subtrees with large enough elements. Index
+// is updated by every added set and rebuilt after removal of sets.
+//
+// Store and index are always complete when a change of SubSets returns, so
+// const methods only read and may be called from many threads at once.
 //
 //-----------------------------------------------------------------------------
 //
@@ -16,22 +45,160 @@
 //
 //-----------------------------------------------------------------------------
 
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <iostream>
 #include <map>
 #include <set>
+#include <type_traits>
 #include <vector>
 
 #include "comb.hpp"
 #include "idomain.hpp"
 
-// to be changed
-using storage_t = unsigned;
+// K 64-bit words, bit i is bit i % 64 of word i / 64
+template <size_t K> class WideWord final {
+  std::array<uint64_t, K> w_{};
+
+public:
+  WideWord(uint64_t v = 0) { w_[0] = v; }
+
+  uint64_t word(size_t k) const { return w_[k]; }
+
+  WideWord &operator&=(const WideWord &rhs) {
+    for (size_t k = 0; k < K; ++k)
+      w_[k] &= rhs.w_[k];
+    return *this;
+  }
+
+  WideWord &operator|=(const WideWord &rhs) {
+    for (size_t k = 0; k < K; ++k)
+      w_[k] |= rhs.w_[k];
+    return *this;
+  }
+
+  WideWord &operator^=(const WideWord &rhs) {
+    for (size_t k = 0; k < K; ++k)
+      w_[k] ^= rhs.w_[k];
+    return *this;
+  }
+
+  WideWord operator~() const {
+    WideWord res;
+    for (size_t k = 0; k < K; ++k)
+      res.w_[k] = ~w_[k];
+    return res;
+  }
+
+  WideWord operator<<(unsigned sh) const {
+    WideWord res;
+    size_t q = sh / 64, r = sh % 64;
+    for (size_t k = K; k-- > q;) {
+      res.w_[k] = w_[k - q] << r;
+      if ((r > 0) && (k > q))
+        res.w_[k] |= w_[k - q - 1] >> (64 - r);
+    }
+    return res;
+  }
+
+  friend WideWord operator&(WideWord a, const WideWord &b) { return a &= b; }
+  friend WideWord operator|(WideWord a, const WideWord &b) { return a |= b; }
+  friend WideWord operator^(WideWord a, const WideWord &b) { return a ^= b; }
+
+  friend bool operator==(const WideWord &a, const WideWord &b) {
+    return a.w_ == b.w_;
+  }
+  friend bool operator!=(const WideWord &a, const WideWord &b) {
+    return !(a == b);
+  }
+
+  // numeric order, as for integers
+  friend bool operator<(const WideWord &a, const WideWord &b) {
+    for (size_t k = K; k-- > 0;)
+      if (a.w_[k] != b.w_[k])
+        return a.w_[k] < b.w_[k];
+    return false;
+  }
+
+  unsigned popcount() const {
+    unsigned res = 0;
+    for (size_t k = 0; k < K; ++k)
+      res += __builtin_popcountll(w_[k]);
+    return res;
+  }
+
+  // number of trailing zeros, shall be nonzero
+  unsigned ctz() const {
+    size_t k = 0;
+    while (w_[k] == 0)
+      k += 1;
+    return k * 64 + __builtin_ctzll(w_[k]);
+  }
+
+  // w & (w - 1)
+  WideWord clear_lowest() const {
+    WideWord res = *this;
+    size_t k = 0;
+    while (res.w_[k] == 0)
+      k += 1;
+    res.w_[k] &= res.w_[k] - 1;
+    return res;
+  }
+};
+
+template <size_t Bits>
+using bitstring_word = std::conditional_t<
+    (Bits <= 32), unsigned,
+    std::conditional_t<(Bits <= 64), uint64_t,
+                       std::conditional_t<(Bits <= 128), __uint128_t,
+                                          WideWord<(Bits + 63) / 64>>>>;
+
+template <typename W> struct is_wide_word : std::false_type {};
+template <size_t K> struct is_wide_word<WideWord<K>> : std::true_type {};
+
+// helpers for integral words, WideWord has them as members
+template <typename W> unsigned bitword_popcount(W w) {
+  if constexpr (is_wide_word<W>::value)
+    return w.popcount();
+  else if constexpr (sizeof(W) > 8)
+    return __builtin_popcountll(uint64_t(w)) +
+           __builtin_popcountll(uint64_t(w >> 64));
+  else
+    return __builtin_popcountll(w);
+}
+
+template <typename W> unsigned bitword_ctz(W w) {
+  if constexpr (is_wide_word<W>::value)
+    return w.ctz();
+  else if constexpr (sizeof(W) > 8)
+    return (uint64_t(w) != 0) ? __builtin_ctzll(uint64_t(w))
+                              : 64 + __builtin_ctzll(uint64_t(w >> 64));
+  else
+    return __builtin_ctzll(w);
+}
+
+template <typename W> W bitword_clear_lowest(W w) {
+  if constexpr (is_wide_word<W>::value)
+    return w.clear_lowest();
+  else
+    return w & (w - 1);
+}
 
 template <typename DomT> class BitString final {
+public:
+  using storage_t = bitstring_word<size_t(DomT::fin)>;
+
+private:
   storage_t s_ = 0;
   using DTT = typename DomT::type;
 
-  // if this is not the case, then we shall invent better storage
-  static_assert(DomT::fin < sizeof(storage_t) * CHAR_BIT);
+  static storage_t bit(DomT delt) { return storage_t(1) << unsigned(delt); }
 
 public:
   BitString(storage_t s = 0) : s_{s} {}
@@ -41,9 +208,9 @@ public:
     assign(il.begin(), il.end());
   }
 
-  operator storage_t() const { return s_; }
+  storage_t bits() const { return s_; }
 
-  unsigned size() const { return __builtin_popcount(s_); }
+  unsigned size() const { return bitword_popcount(s_); }
 
   template <typename Fwd> void assign(Fwd start, Fwd fin) {
     for (auto it = start; it != fin; ++it)
@@ -51,20 +218,20 @@ public:
   }
 
   // inclusion check
-  bool includes(DomT delt) { return ((s_ | (1 << delt)) == s_); }
+  bool includes(DomT delt) { return ((s_ | bit(delt)) == s_); }
 
   // extend {1, 3, 4} with, say, 7
   bool extend(DomT delt) {
     if (includes(delt))
       return false;
-    s_ |= (1 << delt);
+    s_ |= bit(delt);
     return true;
   }
 
   bool remove(DomT delt) {
     if (!includes(delt))
       return false;
-    s_ &= ~(1 << delt);
+    s_ &= ~bit(delt);
     return true;
   }
 
@@ -77,6 +244,22 @@ public:
   // B1 - B2
   void operator-=(const BitString &rhs) { s_ = (s_ & ~rhs.s_); }
 
+  friend BitString operator&(const BitString &a, const BitString &b) {
+    return BitString(a.s_ & b.s_);
+  }
+  friend BitString operator|(const BitString &a, const BitString &b) {
+    return BitString(a.s_ | b.s_);
+  }
+  friend bool operator==(const BitString &a, const BitString &b) {
+    return a.s_ == b.s_;
+  }
+  friend bool operator!=(const BitString &a, const BitString &b) {
+    return !(a == b);
+  }
+  friend bool operator<(const BitString &a, const BitString &b) {
+    return a.s_ < b.s_;
+  }
+
   std::ostream &dump(std::ostream &os) const {
     if (s_ == 0) {
       os << "{}";
@@ -84,7 +267,7 @@ public:
     }
 
     for (auto delt = DomT::start; delt != DomT::fin; ++delt)
-      if ((s_ & (1 << delt)) == (1 << delt))
+      if ((s_ & bit(delt)) == bit(delt))
         os << delt;
     return os;
   }
@@ -96,11 +279,11 @@ private:
   public:
     Iter(storage_t s = 0) : s_{s} {}
     DomT operator*() {
-      assert(s_ != 0);
-      return __builtin_ctz(s_);
+      assert(s_ != storage_t(0));
+      return bitword_ctz(s_);
     }
     Iter &operator++() {
-      s_ = (s_ & (s_ - 1));
+      s_ = bitword_clear_lowest(s_);
       return *this;
     }
     Iter operator++(int) {
@@ -117,10 +300,189 @@ public:
   Iter end() { return Iter{}; }
 };
 
-template <typename DomT> class SubSets final {
+// sorted vector: v_[0 .. sorted_) is sorted and has no duplicates, the rest
+// are inserts not yet merged by settle(), which shall go before any read.
+// Const methods change nothing.
+template <typename T> class FlatSet final {
+  std::vector<T> v_;
+  size_t sorted_ = 0;
+
+public:
+  using const_iterator = typename std::vector<T>::const_iterator;
+
+  void settle() {
+    if (sorted_ == v_.size())
+      return;
+
+    // single insert goes to its place, many are sorted at once
+    if (sorted_ + 1 == v_.size()) {
+      T x = v_.back();
+      v_.pop_back();
+      auto it = std::lower_bound(v_.begin(), v_.end(), x);
+      if ((it == v_.end()) || (x < *it))
+        v_.insert(it, x);
+      sorted_ = v_.size();
+      return;
+    }
+
+    auto mid = v_.begin() + sorted_;
+    std::sort(mid, v_.end());
+    std::inplace_merge(v_.begin(), mid, v_.end());
+    v_.erase(std::unique(v_.begin(), v_.end()), v_.end());
+    sorted_ = v_.size();
+  }
+
+  bool settled() const { return sorted_ == v_.size(); }
+
+  void insert(const T &x) { v_.push_back(x); }
+
+  template <typename It> void insert(It start, It fin) {
+    v_.insert(v_.end(), start, fin);
+  }
+
+  size_t erase(const T &x) {
+    settle();
+    auto it = std::lower_bound(v_.begin(), v_.end(), x);
+    if ((it == v_.end()) || (x < *it))
+      return 0;
+    v_.erase(it);
+    sorted_ -= 1;
+    return 1;
+  }
+
+  size_t count(const T &x) const {
+    assert(settled());
+    return std::binary_search(v_.begin(), v_.end(), x);
+  }
+
+  void clear() {
+    v_.clear();
+    sorted_ = 0;
+  }
+
+  size_t size() const {
+    assert(settled());
+    return v_.size();
+  }
+
+  const_iterator begin() const {
+    assert(settled());
+    return v_.cbegin();
+  }
+  const_iterator end() const {
+    assert(settled());
+    return v_.cend();
+  }
+  const_iterator cbegin() const { return begin(); }
+  const_iterator cend() const { return end(); }
+};
+
+// other stores, like std::set, are always settled
+template <typename S> void store_settle(S &) {}
+template <typename T> void store_settle(FlatSet<T> &s) { s.settle(); }
+
+// set-trie over sets of BST, see above
+template <typename BST> class SupersetIndex final {
+  // children of node are list by sibling in increasing order of elt, maxelt
+  // is the largest element in subtree, 0 is root and null link
+  struct node {
+    unsigned elt, maxelt;
+    unsigned child, sibling;
+  };
+  std::vector<node> nodes_{node{0, 0, 0, 0}};
+  size_t nsets_ = 0;
+
+  // elements [it, fin) of query are still to be matched below cur, top is
+  // the largest one
+  template <typename It>
+  bool find(unsigned cur, It it, It fin, unsigned top) const {
+    unsigned want = *it;
+    It next = it;
+    ++next;
+    for (unsigned c = nodes_[cur].child; c != 0; c = nodes_[c].sibling) {
+      const node &nd = nodes_[c];
+      if (nd.elt > want)
+        break;
+      if (nd.maxelt < top)
+        continue;
+      if (nd.elt == want) {
+        if ((next == fin) || find(c, next, fin, top))
+          return true;
+      } else if (find(c, it, fin, top))
+        return true;
+    }
+    return false;
+  }
+
+public:
+  void clear() {
+    nodes_.resize(1);
+    nodes_[0].child = 0;
+    nsets_ = 0;
+  }
+
+  void insert(BST b) {
+    nsets_ += 1;
+    if (b.size() == 0)
+      return;
+    unsigned top = 0;
+    for (auto e : b)
+      top = e;
+
+    unsigned cur = 0;
+    for (auto e : b) {
+      unsigned v = e, prev = 0, c = nodes_[cur].child;
+      while ((c != 0) && (nodes_[c].elt < v)) {
+        prev = c;
+        c = nodes_[c].sibling;
+      }
+      if ((c == 0) || (nodes_[c].elt != v)) {
+        nodes_.push_back(node{v, top, 0, c});
+        c = nodes_.size() - 1;
+        if (prev == 0)
+          nodes_[cur].child = c;
+        else
+          nodes_[prev].sibling = c;
+      }
+      nodes_[c].maxelt = std::max(nodes_[c].maxelt, top);
+      cur = c;
+    }
+  }
+
+  // is there set, containing x
+  bool has_superset(BST x) const {
+    if (x.size() == 0)
+      return nsets_ > 0;
+    unsigned top = 0;
+    for (auto e : x)
+      top = e;
+    return find(0, x.begin(), x.end(), top);
+  }
+};
+
+template <typename DomT, typename StoreT = FlatSet<BitString<DomT>>>
+class SubSets final {
   using DTT = typename DomT::type;
   using BST = BitString<DomT>;
-  std::set<BST> b_;
+  StoreT b_;
+
+  // superset index of b_
+  SupersetIndex<BST> idx_;
+
+  // adds are followed by settle at the end of change
+  void add(BST b) {
+    b_.insert(b);
+    idx_.insert(b);
+  }
+
+  void settle() { store_settle(b_); }
+
+  // helper: index from scratch, after sets are removed
+  void reindex() {
+    idx_.clear();
+    for (auto bst : b_)
+      idx_.insert(bst);
+  }
 
 public:
   SubSets() = default;
@@ -140,41 +502,57 @@ public:
       }
       BST bs;
       bs.assign(nums.begin(), nums.end());
-      b_.insert(bs);
+      add(bs);
     }
+    settle();
   }
 
   // fill with all subsets of size sz
   // fill_exact(3, 7): 123, 124, ... 456
-  void fill_exact(unsigned sz, DomT fin = DomT::fin) {
-    all_comb ac(fin - DomT::start, sz);
-    do {
-      BST bs;
-      for (auto it = ac.begin(); it != ac.end(); ++it)
-        bs.extend(*it + DomT::start);
-      b_.insert(bs);
-    } while (ac.next_comb());
+  void fill_exact(unsigned sz, DTT fin = DomT::fin) {
+    using W = typename BST::storage_t;
+    if constexpr (is_wide_word<W>::value) {
+      revolving_mask<W> rm(fin - DomT::start, sz);
+      do
+        add(BST(rm.mask() << DomT::start));
+      while (rm.next_comb());
+    } else {
+      colex_mask<W> cm(fin - DomT::start, sz);
+      do
+        add(BST(cm.mask() << DomT::start));
+      while (cm.next_comb());
+    }
+    settle();
   }
 
   // fill with all subsets up to size sz
-  void fill(unsigned sz, DomT fin = DomT::fin) {
+  void fill(unsigned sz, DTT fin = DomT::fin) {
     for (int i = 1; i <= sz; ++i)
       fill_exact(i, fin);
   }
 
-  void extend(BST b) { b_.insert(b); }
+  void extend(BST b) {
+    add(b);
+    settle();
+  }
 
   template <typename Fwd> void assign(Fwd start, Fwd fin) {
     for (auto it = start; it != fin; ++it)
-      b_.insert(*it);
+      add(*it);
+    settle();
   }
 
   template <typename Fwd> void exclude(Fwd start, Fwd fin) {
     for (auto it = start; it != fin; ++it)
       b_.erase(*it);
+    settle();
+    reindex();
   }
 
-  void clear() { b_.clear(); }
+  void clear() {
+    b_.clear();
+    idx_.clear();
+  }
 
   auto begin() { return b_.begin(); }
   auto end() { return b_.end(); }
@@ -195,15 +573,7 @@ public:
   }
 
   bool contains(BST elt) const {
-    if (b_.find(elt) != b_.end())
-      return true;
-
-    // costly step, need custom search tree?
-    for (auto bst : b_)
-      if (bst.contains(elt))
-        return true;
-
-    return false;
+    return b_.count(elt) || idx_.has_superset(elt);
   }
 
   void eliminate(const SubSets &cs) {
@@ -230,6 +600,8 @@ public:
 
       b_.clear();
       b_.insert(velts.begin(), velts.end());
+      settle();
+      reindex();
     }
   }
 
@@ -240,7 +612,8 @@ public:
   bool check_bases() const;
 };
 
-template <typename DomT> bool SubSets<DomT>::check_indep() const {
+template <typename DomT, typename StoreT>
+bool SubSets<DomT, StoreT>::check_indep() const {
   for (auto it = b_.begin(); it != b_.end(); ++it)
     for (auto it2 = it; it2 != b_.end(); ++it2) {
       if (it->size() > it2->size()) {
@@ -271,7 +644,8 @@ template <typename DomT> bool SubSets<DomT>::check_indep() const {
   return true;
 }
 
-template <typename DomT> bool SubSets<DomT>::check_bases() const {
+template <typename DomT, typename StoreT>
+bool SubSets<DomT, StoreT>::check_bases() const {
   for (auto it = b_.begin(); it != b_.end(); ++it)
     for (auto it2 = std::next(it); it2 != b_.end(); ++it2) {
       if (it->size() != it2->size())
@@ -293,7 +667,7 @@ template <typename DomT> bool SubSets<DomT>::check_bases() const {
           auto AUG = B1;
           AUG.remove(x);
           AUG.extend(y);
-          if (b_.find(AUG) != b_.end()) {
+          if (b_.count(AUG)) {
             found = true;
             break;
           }
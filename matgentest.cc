@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "matgen.hpp"
+
+// same operations for every storage width, last elements included
+template <unsigned Fin> void test_bitstring() {
+  using Dom = UnsignedDomain<0, Fin>;
+  using BS = BitString<Dom>;
+
+  std::vector<unsigned> elts{0, 1, Fin / 2, Fin - 2, Fin - 1};
+  BS a;
+  for (auto e : elts)
+    assert(a.extend(e));
+  assert(!a.extend(Fin - 1));
+  assert(a.size() == elts.size());
+
+  std::vector<unsigned> back;
+  for (auto e : a)
+    back.push_back(e);
+  assert(back == elts);
+
+  BS b{1, Fin - 1};
+  assert(a.contains(b) && !b.contains(a));
+  assert((a & b) == b);
+  assert((a | b) == a);
+  assert(b < a);
+
+  BS c = a;
+  c -= b;
+  assert(c.size() == elts.size() - 2);
+  assert(!c.includes(Fin - 1) && c.includes(Fin - 2));
+  assert(c.remove(Fin - 2) && !c.remove(Fin - 2));
+
+  SubSets<Dom> ss;
+  ss.fill_exact(2);
+  assert(ss.size() == comb_binomial(Fin, 2));
+  assert(ss.contains(BS{0, Fin - 1}));
+  assert(!ss.contains(BS{0, 1, Fin - 1}));
+}
+
+// flat store shall behave as std::set, order of iteration included
+void test_stores() {
+  using Dom = UnsignedDomain<0, 12>;
+  using BS = BitString<Dom>;
+  SubSets<Dom> flat;
+  SubSets<Dom, std::set<BS>> tree;
+
+  auto same = [&] {
+    assert(flat.size() == tree.size());
+    assert(std::equal(flat.cbegin(), flat.cend(), tree.cbegin()));
+  };
+
+  flat.fill(3);
+  tree.fill(3);
+  same();
+
+  std::vector<BS> more{BS{1, 2}, BS{0, 1, 2, 3}, BS{5, 7, 9, 11}};
+  flat.assign(more.begin(), more.end());
+  tree.assign(more.begin(), more.end());
+  same();
+
+  std::vector<BS> less{BS{1, 2}, BS{4, 5, 6}, BS{0, 10, 11}};
+  flat.exclude(less.begin(), less.end());
+  tree.exclude(less.begin(), less.end());
+  same();
+
+  for (auto &b : less)
+    assert(flat.contains(b) == tree.contains(b));
+  assert(flat.contains(BS{5, 7}) && tree.contains(BS{5, 7}));
+  assert(flat.check_indep() == tree.check_indep());
+
+  SubSets<Dom> fcs;
+  SubSets<Dom, std::set<BS>> tcs;
+  fcs.fill(2);
+  tcs.fill(2);
+  flat.eliminate(fcs);
+  tree.eliminate(tcs);
+  same();
+}
+
+// contains shall be linear scan, also after adds and removals of sets
+template <unsigned Fin> void test_contains(unsigned seed) {
+  using Dom = UnsignedDomain<0, Fin>;
+  using BS = BitString<Dom>;
+  std::mt19937 gen(seed);
+  auto rnd = [&](unsigned maxsz) {
+    BS b;
+    unsigned sz = gen() % (maxsz + 1);
+    for (unsigned i = 0; i < sz; ++i)
+      b.extend(gen() % Fin);
+    return b;
+  };
+
+  SubSets<Dom> ss;
+  std::vector<BS> members;
+  auto check = [&] {
+    for (int q = 0; q < 200; ++q) {
+      BS x = rnd(4);
+      bool expected = false;
+      for (auto &m : members)
+        expected = expected || m.contains(x);
+      assert(ss.contains(x) == expected);
+    }
+  };
+
+  check();
+  for (int round = 0; round < 5; ++round) {
+    for (int i = 0; i < 50; ++i) {
+      members.push_back(rnd(Fin / 2));
+      ss.extend(members.back());
+    }
+    check();
+  }
+
+  std::vector<BS> gone(members.begin(), members.begin() + 100);
+  ss.exclude(gone.begin(), gone.end());
+  members.erase(std::remove_if(members.begin(), members.end(),
+                               [&](const BS &m) {
+                                 return std::find(gone.begin(), gone.end(),
+                                                  m) != gone.end();
+                               }),
+                members.end());
+  check();
+
+  // const queries only read, so threads may share one set
+  std::vector<BS> qs;
+  std::vector<char> expected;
+  for (int q = 0; q < 400; ++q) {
+    qs.push_back(rnd(4));
+    expected.push_back(ss.contains(qs.back()));
+  }
+  const auto &css = ss;
+  std::vector<std::thread> ts;
+  for (int t = 0; t < 4; ++t)
+    ts.emplace_back([&] {
+      for (size_t q = 0; q < qs.size(); ++q)
+        assert(css.contains(qs[q]) == bool(expected[q]));
+    });
+  for (auto &t : ts)
+    t.join();
+}
+
+int main() {
+  static_assert(std::is_same_v<BitString<UnsignedDomain<0, 32>>::storage_t,
+                               unsigned>);
+  static_assert(std::is_same_v<BitString<UnsignedDomain<0, 40>>::storage_t,
+                               uint64_t>);
+  static_assert(std::is_same_v<BitString<UnsignedDomain<0, 100>>::storage_t,
+                               __uint128_t>);
+  static_assert(std::is_same_v<BitString<UnsignedDomain<0, 256>>::storage_t,
+                               WideWord<4>>);
+
+  test_bitstring<10>();
+  test_bitstring<32>();
+  test_bitstring<40>();
+  test_bitstring<64>();
+  test_bitstring<100>();
+  test_bitstring<128>();
+  test_bitstring<200>();
+  test_bitstring<256>();
+
+  test_stores();
+
+  for (unsigned seed = 1; seed <= 5; ++seed) {
+    test_contains<12>(seed);
+    test_contains<40>(seed);
+    test_contains<200>(seed);
+  }
+
+  BitString<UnsignedDomain<0, 256>> wide{3, 64, 130, 255};
+  wide.dump(std::cout);
+  std::cout << std::endl;
+}
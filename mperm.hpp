@@ -0,0 +1,141 @@
+//------------------------------------------------------------------------------
+//
+// this file implements all permutations of multiset in lexicographic order
+// usage (permutations of 1, 1, 2):
+//
+//  MultisetPerm<int> mp({1, 1, 2});
+//  do {
+//    for (auto v : mp)
+//      std::cout << v << " ";
+//    std::cout << std::endl;
+//  } while (mp.next());
+//
+// output:
+// 1 1 2
+// 1 2 1
+// 2 1 1
+//
+// skip_prefix(k) goes straight to the first permutation with other first k
+// elements, say from 1 1 2 3 skip_prefix(2) gives 1 2 1 3, and rest(k) tells
+// how many permutations it jumps over:
+//
+//  1 1 2 3   <- current
+//  1 1 3 2   <- rest(2) == 1
+//  1 2 1 3   <- after skip_prefix(2)
+//
+// Details may be found in Knuth, algorithm L from 7.2.1.2 (vol 4A)
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+// helper: number of distinct permutations of sorted range [first, last)
+template <typename Iter> size_t count_mperm_sorted(Iter first, Iter last) {
+  size_t res = 1, total = 0;
+  while (first != last) {
+    Iter run = first;
+    size_t cnt = 0;
+    while ((first != last) && (*first == *run)) {
+      ++first;
+      ++cnt;
+    }
+
+    // res *= binomial(total + cnt, cnt), one factor at a time, every
+    // partial product is binomial itself, so division is exact
+    for (size_t idx = 1; idx <= cnt; ++idx) {
+      total += 1;
+      if (__builtin_mul_overflow(res, total, &res))
+        throw std::overflow_error("Multiset permutations count overflow");
+      res /= idx;
+    }
+  }
+  return res;
+}
+
+template <typename T> class MultisetPerm {
+  std::vector<T> a_;
+
+public:
+  // starts from given arrangement, not necessarily from sorted one
+  explicit MultisetPerm(std::vector<T> a) : a_(std::move(a)) {}
+
+  auto begin() const { return a_.begin(); }
+  auto end() const { return a_.end(); }
+  size_t size() const { return a_.size(); }
+  const T &operator[](size_t idx) const { return a_[idx]; }
+  const std::vector<T> &get() const { return a_; }
+
+  // L1 .. L4, false if current permutation is the last one
+  bool next() {
+    size_t n = a_.size();
+    if (n < 2)
+      return false;
+
+    // L2: find j, such that a[j] < a[j + 1]
+    size_t j = n - 2;
+    while (!(a_[j] < a_[j + 1])) {
+      if (j == 0)
+        return false;
+      j -= 1;
+    }
+
+    // L3: increase a[j] by smallest larger element to the right
+    size_t l = n - 1;
+    while (!(a_[j] < a_[l]))
+      l -= 1;
+    std::swap(a_[j], a_[l]);
+
+    // L4: reverse a[j + 1] .. a[n - 1]
+    std::reverse(a_.begin() + j + 1, a_.end());
+    return true;
+  }
+
+  // number of permutations after current one with the same first k elements
+  size_t rest(size_t k) const {
+    assert(k <= a_.size());
+    std::vector<T> tail(a_.begin() + k, a_.end());
+    std::sort(tail.begin(), tail.end());
+
+    // rank of current tail among permutations of tail: for every position
+    // count permutations with smaller element here
+    size_t rank = 0;
+    for (size_t pos = k; pos < a_.size(); ++pos) {
+      for (size_t idx = 0; idx < tail.size(); ++idx) {
+        if (!(tail[idx] < a_[pos]))
+          break;
+        if ((idx > 0) && (tail[idx] == tail[idx - 1]))
+          continue;
+        T v = tail[idx];
+        tail.erase(tail.begin() + idx);
+        rank += count_mperm_sorted(tail.begin(), tail.end());
+        tail.insert(tail.begin() + idx, v);
+      }
+      tail.erase(std::lower_bound(tail.begin(), tail.end(), a_[pos]));
+    }
+
+    std::vector<T> all(a_.begin() + k, a_.end());
+    std::sort(all.begin(), all.end());
+    return count_mperm_sorted(all.begin(), all.end()) - 1 - rank;
+  }
+
+  // all permutations with the same first k elements are skipped, false if
+  // there is nothing after them
+  bool skip_prefix(size_t k) {
+    assert(k <= a_.size());
+    std::sort(a_.begin() + k, a_.end(), std::greater<T>());
+    return next();
+  }
+};
@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <cassert>
+#include <iostream>
+#include <vector>
+
+#include "mperm.hpp"
+
+// walk shall be std::next_permutation walk, rest and skip_prefix shall
+// agree with it
+void test_mperm(std::vector<int> a) {
+  std::sort(a.begin(), a.end());
+  std::vector<std::vector<int>> all;
+  do
+    all.push_back(a);
+  while (std::next_permutation(a.begin(), a.end()));
+  assert(all.size() == count_mperm_sorted(all[0].begin(), all[0].end()));
+
+  MultisetPerm<int> mp(all[0]);
+  for (size_t idx = 0; idx < all.size(); ++idx) {
+    assert(mp.get() == all[idx]);
+
+    for (size_t k = 0; k <= a.size(); ++k) {
+      size_t last = idx;
+      while ((last + 1 < all.size()) &&
+             std::equal(all[idx].begin(), all[idx].begin() + k,
+                        all[last + 1].begin()))
+        last += 1;
+      assert(mp.rest(k) == last - idx);
+
+      MultisetPerm<int> sp(mp.get());
+      bool more = sp.skip_prefix(k);
+      assert(more == (last + 1 < all.size()));
+      if (more)
+        assert(sp.get() == all[last + 1]);
+    }
+
+    assert(mp.next() == (idx + 1 < all.size()));
+  }
+}
+
+int main() {
+  test_mperm({1});
+  test_mperm({1, 1, 2});
+  test_mperm({1, 1, 2, 3});
+  test_mperm({1, 1, 1, 2, 4});
+  test_mperm({1, 1, 2, 2, 3, 3});
+  test_mperm({1, 1, 1, 1, 1, 2, 9});
+  test_mperm({1, 2, 3, 4, 5, 6});
+  test_mperm({1, 1, 1, 2, 2, 3, 4, 6});
+
+  std::vector<size_t> big(24, 1);
+  big[20] = big[21] = 2;
+  big[22] = big[23] = 3;
+  std::cout << "permutations of 20 ones, 2, 2, 3, 3: "
+            << count_mperm_sorted(big.begin(), big.end()) << std::endl;
+}
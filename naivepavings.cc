@@ -11,234 +11,77 @@
 //
 //------------------------------------------------------------------------------
 
-#include <algorithm>
+#include <array>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
-#include <map>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
-#include "field.hpp"
-#include "hind.hpp"
+#include "bitfield.hpp"
+#include "btypes.hpp"
+#include "pavgen.hpp"
+#include "tpcount.hpp"
 
+using std::array;
 using std::cout;
 using std::endl;
-using std::fill;
-using std::find_if;
-using std::make_pair;
-using std::map;
+using std::index_sequence;
+using std::make_index_sequence;
 using std::max;
-using std::minmax_element;
-using std::next_permutation;
-using std::pair;
-using std::sort;
+using std::stod;
 using std::stol;
 using std::strlen;
+using std::thread;
 
-struct genconfig {
-  bool only_stat = false;
-  bool no_stat = false;
-  bool only_vtype = false;
-  bool only_count = false;
-};
+// pre-instantiated generators for small fields, where all sizes are
+// compile-time constants: fixed_gens[n - 2][m - 2]
+constexpr size_t maxfixed = 8;
 
-size_t naive_gen(size_t N, size_t M, genconfig gcf) {
-  size_t count_ss = 0;
-  size_t count_np = 0;
-  size_t count_nt = 0;
-  size_t count_tp = 0;
-  size_t count_vt = 0;
+// -j is limited by this number of threads per core
+constexpr size_t maxthreads_per_core = 4;
+using gen_t = size_t (*)(size_t, size_t, genconfig);
 
-  // 1. enumerate possible block types
-  //    (1 .. M-1) x (1 .. N-1) + 1 x N + 1 x M
-  //   say 2:1 and 1:2 both have counter 2
-  //
-  //   btypecnts[2] == 2
-  //   btypes[<2, 0>] = <2, 1>
-  //   btypes[<2, 1>] = <1, 2>
-
-  size_t nbtypes = max({N, M, (N - 1) * (M - 1)});
-  vector<size_t> btypecnts(nbtypes + 1);
-  map<pair<size_t, size_t>, pair<size_t, size_t>> btypes{};
-  map<vector<size_t>, size_t> genfunc;
-
-  btypes[make_pair(N, btypecnts[N])] = make_pair(N, 1);
-  btypecnts[N] += 1;
-
-  btypes[make_pair(M, btypecnts[M])] = make_pair(1, M);
-  btypecnts[M] += 1;
-
-  for (size_t horz = 1; horz < N; ++horz)
-    for (size_t vert = 1; vert < M; ++vert) {
-      btypes[make_pair(horz * vert, btypecnts[horz * vert])] =
-          make_pair(horz, vert);
-      btypecnts[horz * vert] += 1;
-    }
-
-  // 2. generate all type signatures of M+N-1 buckets
-  //    with discrete allowed number of balls in each
-  //
-  //    n is allowed <=> btypecnts[n] != 0
-  //    1 is always allowed (1x1 block)
-  //
-  //    say for M*N = 9 and allowed numbers 1, 2, 3, 4
-  //    possible signatures:
-  //
-  //    1, 1, 1, 2, 4
-  //    1, 1, 1, 3, 3
-  //    1, 1, 2, 2, 3
-  //    1, 2, 2, 2, 2
-  //
-  //    and all permutations
-
-  size_t bsize = 1;
-  for (size_t cnt = 2; cnt < btypecnts.size(); ++cnt)
-    if (btypecnts[cnt] > 0)
-      bsize = cnt;
-
-  size_t mback = (M + N - 1);
-  size_t nballs = M * N;
-  vector<size_t> bcnt(mback, 1);
-  size_t excessballs = nballs - mback;
-
-  // form minimal signature 1, 1 ... 1, r, n ... n
-  // 2x2: 1, 1, 2
-  // 2x3: 1, 1, 1, 3
-  // 3x3: 1, 1, 1, 2, 4
-  // 4x3: 1, 1, 1, 1, 2, 6
-  // 4x4: 1, 1, 1, 1, 1, 2, 9
-  // suppose that r is always available number. As shown above it is always true
-  // for small numbers, but general case shall be proven separately, I think
-
-  size_t curback = mback - 1;
-  while (excessballs > 0) {
-    if (excessballs > bsize - 1) {
-      bcnt[curback] = bsize;
-      excessballs -= (bsize - 1);
-      assert(curback > 0);
-      curback -= 1;
-    } else {
-      assert(btypecnts[excessballs + 1] > 0);
-      assert(bcnt[curback] == 1);
-      bcnt[curback] += excessballs;
-      excessballs = 0;
-    }
-  }
-
-  do {
-    if (bcnt.end() != find_if(bcnt.begin(), bcnt.end(),
-                              [&](size_t b) { return btypecnts[b] == 0; }))
-      continue;
-
-    do {
-      // 3. for given signature generate all mixed-radix tuples
-      //    say for 2, 1, 1, 2, 3
-      //    btypecnts[1] == 1, btypecnts[2] == 2, btypecnts[3] == 2
-      //    solutions are:
-      //
-      //    0, 0, 0, 0, 0
-      //    0, 0, 0, 0, 1
-      //    0, 0, 0, 1, 0
-      //    0, 0, 0, 1, 1
-      //    1, 0, 0, 0, 0
-      //    1, 0, 0, 0, 1
-      //    1, 0, 0, 1, 0
-      //    1, 0, 0, 1, 1
-
-      vector<size_t> bmix(mback, 0);
-
-      for (;;) {
-        // 4. for mixed-radix tuple and signature fill field with btypes[<i, j>]
-        // blocks
-        //    filter out non-pavings
-        //    filter-out non-tight pavings
-
-        Field f(N, M);
-        bool succ = true;
-
-        for (size_t idx = 0; idx < mback; ++idx) {
-          auto elt = btypes[make_pair(bcnt[idx], bmix[idx])];
-          succ = f.put(elt.first, elt.second);
-          if (!succ)
-            break;
-        }
-
-        count_ss += 1;
-
-        if (!f.all())
-          count_np += 1;
-
-        if (f.all() && !f.tight()) {
-          count_nt += 1;
-        }
-
-        if (f.all() && f.tight()) {
-          count_tp += 1;
-          if (!gcf.only_stat && !gcf.only_vtype) {
-            f.dump(cout);
-            cout << endl;
-          }
-          if (f.vtype()) {
-            count_vt += 1;
-            auto v = f.vtype_signature();
-            if (!gcf.only_stat && gcf.only_vtype) {
-              f.dump(cout);             
-              cout << '\t';
-              for (auto s : v)
-                cout << s << ' ';
-              cout << endl;
-            }
-            sort(v.begin(), v.end());
-            genfunc[v] += 1;
-          }
-        }
-
-        size_t digit = mback;
-
-        while (digit > 0) {
-          digit -= 1;
-          if (bmix[digit] + 1 < btypecnts[bcnt[digit]]) {
-            bmix[digit] += 1;
-            break;
-          }
-          bmix[digit] = 0;
-        }
+template <size_t Idx> constexpr gen_t fixed_gen() {
+  constexpr size_t n = Idx / (maxfixed - 1) + 2;
+  constexpr size_t m = Idx % (maxfixed - 1) + 2;
+  return &naive_gen<FixedField<n, m>, FixedBlockTypes<n, m>>;
+}
 
-        size_t bsum = 0;
-        for (auto b : bmix)
-          bsum += b;
-        if (bsum == 0)
-          break;
-      }
-    } while (next_permutation(bcnt.begin(), bcnt.end()));
-  } while (next_break_of(M * N, M + N - 1, bcnt.begin(), bcnt.end()));
+template <size_t... Idx>
+constexpr array<gen_t, sizeof...(Idx)> fixed_gens(index_sequence<Idx...>) {
+  return {fixed_gen<Idx>()...};
+}
 
-  if (!gcf.no_stat) {
-    if (!gcf.only_count) {
-      cout << "Statistics: " << endl;
-      cout << "Search space size: " << count_ss << endl;
-      cout << "Not a pavings: " << count_np << endl;
-      cout << "Not tight pavings: " << count_nt << endl;
-    }
-    cout << "Tight pavings: " << count_tp << endl;
-    if (!gcf.only_count) {
-      cout << "Vertical types: " << count_vt << endl;
-      cout << "Generation function: ";
-      for (auto g : genfunc) {
-        if (g != *genfunc.begin())
-          cout << "+";
-        if (g.second > 1)
-          cout << g.second;
-        for (auto f: g.first)
-          cout << "f" << f;      
-      }
-      cout << endl;
-    }
-  }
+constexpr auto fixed_gen_table =
+    fixed_gens(make_index_sequence<(maxfixed - 1) * (maxfixed - 1)>{});
+
+// counting without enumeration, see tpcount.hpp
+size_t transfer_gen(size_t N, size_t M, genconfig gcf) {
+  auto tpc = count_tight_pavings(N, M, !gcf.only_count);
+  genstat st;
+  st.count_tp = tpc.count_tp;
+  st.count_vt = tpc.count_vt;
+  st.genfunc = tpc.genfunc;
+  print_genstat(st, gcf);
+  return st.count_tp;
+}
 
-  // 5. return result
-  return count_tp;
+// helper: shard i/k with 0 <= i < k, false for anything else
+bool parse_shard(const char *arg, size_t &shard, size_t &nshards) {
+  char *endp = nullptr;
+  long i = strtol(arg, &endp, 10);
+  if ((endp == arg) || (*endp != '/') || (i < 0))
+    return false;
+  const char *karg = endp + 1;
+  long k = strtol(karg, &endp, 10);
+  if ((endp == karg) || (*endp != '\0') || (i >= k))
+    return false;
+  shard = i;
+  nshards = k;
+  return true;
 }
 
 void printusage(char *argv0) {
@@ -249,8 +92,19 @@ void printusage(char *argv0) {
   cout << "Options supported are:" << endl;
   cout << "\t-s -- show statistics only" << endl;
   cout << "\t-n -- show no statistics" << endl;
-  cout << "\t-c -- only count pavings" << endl;
+  cout << "\t-c -- only count pavings (by transfer matrix)" << endl;
+  cout << "\t-t -- only statistics by transfer matrix" << endl;
   cout << "\t-v -- show vtype pavings" << endl;
+  cout << "\t-y -- enumerate up to symmetries of rectangle" << endl;
+  cout << "\t-j N -- run on N threads" << endl;
+  cout << "\t-o file -- write pavings to binary file (see pavread)" << endl;
+  cout << "\t-k file -- save checkpoints to file" << endl;
+  cout << "\t-i sec -- checkpoint interval (default 600 seconds)" << endl;
+  cout << "\t-r -- resume from checkpoint, given by -k" << endl;
+  cout << "\t-d i/k -- enumerate only shard i of 0 .. k-1" << endl;
+  cout << "\t-e file -- save statistics of shard to file" << endl;
+  cout << "\t-m file -- merge statistics of shards (repeat for every file)"
+       << endl;
 }
 
 int main(int argc, char **argv) {
@@ -259,17 +113,21 @@ int main(int argc, char **argv) {
     return -1;
   }
 
-  auto n = stol(argv[1]);
-  auto m = stol(argv[2]);
+  auto narg = stol(argv[1]);
+  auto marg = stol(argv[2]);
 
-  if (n < 2 || m < 2) {
+  if (narg < 2 || marg < 2) {
     printusage(argv[0]);
     return -1;
   }
 
+  size_t n = narg, m = marg;
+
   genconfig gcf;
+  vector<string> merge;
+  bool threads_given = false;
 
-  for (size_t nopt = 3; nopt < argc; ++nopt) {
+  for (int nopt = 3; nopt < argc; ++nopt) {
     if (argv[nopt][0] != '-') {
       printusage(argv[0]);
       cout << "Please prepend options with - and pass separately" << endl;
@@ -289,10 +147,94 @@ int main(int argc, char **argv) {
       break;
     case 'c':
       gcf.only_count = true;
+      gcf.transfer = true;
+      break;
+    case 't':
+      gcf.transfer = true;
       break;
     case 'v':
       gcf.only_vtype = true;
       break;
+    case 'y':
+      gcf.symmetric = true;
+      break;
+    case 'j': {
+      // more threads than some per core only hurt, so they are not allowed
+      size_t maxthreads = maxthreads_per_core *
+                          max(1u, thread::hardware_concurrency());
+      char *endp = nullptr;
+      long nt = (nopt + 1 == argc) ? 0 : strtol(argv[nopt + 1], &endp, 10);
+      if ((nt <= 0) || (*endp != '\0') || (size_t(nt) > maxthreads)) {
+        printusage(argv[0]);
+        cout << "Note: -j requires number of threads 1 .. " << maxthreads
+             << endl;
+        return -1;
+      }
+      nopt += 1;
+      threads_given = true;
+      gcf.nthreads = nt;
+      break;
+    }
+    case 'o':
+      if (nopt + 1 == argc) {
+        printusage(argv[0]);
+        cout << "Note: -o requires file name" << endl;
+        return -1;
+      }
+      nopt += 1;
+      gcf.binout = argv[nopt];
+      break;
+    case 'k':
+      if (nopt + 1 == argc) {
+        printusage(argv[0]);
+        cout << "Note: -k requires file name" << endl;
+        return -1;
+      }
+      nopt += 1;
+      gcf.checkpoint = argv[nopt];
+      break;
+    case 'i': {
+      char *endp = nullptr;
+      double sec = (nopt + 1 == argc) ? -1 : strtod(argv[nopt + 1], &endp);
+      if (!(sec >= 0) || (endp == argv[nopt + 1]) || (*endp != '\0')) {
+        printusage(argv[0]);
+        cout << "Note: -i requires number of seconds >= 0" << endl;
+        return -1;
+      }
+      nopt += 1;
+      gcf.checkpoint_period = sec;
+      break;
+    }
+    case 'r':
+      gcf.resume = true;
+      break;
+    case 'd':
+      if ((nopt + 1 == argc) ||
+          !parse_shard(argv[nopt + 1], gcf.shard, gcf.nshards)) {
+        printusage(argv[0]);
+        cout << "Note: -d requires shard as i/k with 0 <= i < k" << endl;
+        return -1;
+      }
+      nopt += 1;
+      break;
+    case 'e':
+      if (nopt + 1 == argc) {
+        printusage(argv[0]);
+        cout << "Note: -e requires file name" << endl;
+        return -1;
+      }
+      nopt += 1;
+      gcf.statout = argv[nopt];
+      break;
+    case 'm':
+      if (nopt + 1 == argc) {
+        printusage(argv[0]);
+        cout << "Note: -m requires file name" << endl;
+        return -1;
+      }
+      nopt += 1;
+      merge.push_back(argv[nopt]);
+      break;
     default:
       printusage(argv[0]);
       cout << "Note: only available options are listed above" << endl;
@@ -300,6 +242,46 @@ int main(int argc, char **argv) {
     }
   }
 
-  naive_gen(n, m, gcf);
+  if (gcf.resume && gcf.checkpoint.empty()) {
+    printusage(argv[0]);
+    cout << "Note: -r requires checkpoint file, given by -k" << endl;
+    return -1;
+  }
+
+  // transfer matrix only counts, everything about enumeration run or its
+  // output makes no sense for it
+  if (gcf.transfer &&
+      ((gcf.nshards > 1) || !gcf.statout.empty() || !gcf.binout.empty() ||
+       gcf.symmetric || !gcf.checkpoint.empty() || threads_given)) {
+    printusage(argv[0]);
+    cout << "Note: -c and -t do not enumerate, so -o, -y, -j, -k, -r, -d "
+            "and -e are not for them"
+         << endl;
+    return -1;
+  }
+
+  try {
+    if (!merge.empty()) {
+      auto st = merge_shard_stats(merge, n, m, gcf.symmetric);
+      print_genstat(st, gcf);
+      return 0;
+    }
+
+    if (gcf.transfer) {
+      transfer_gen(n, m, gcf);
+      return 0;
+    }
+
+    // fixed sizes are fastest, bitboard is limited to 64 cells
+    if ((n <= maxfixed) && (m <= maxfixed))
+      fixed_gen_table[(n - 2) * (maxfixed - 1) + (m - 2)](n, m, gcf);
+    else if (n * m <= 64)
+      naive_gen<BitField>(n, m, gcf);
+    else
+      naive_gen<Field>(n, m, gcf);
+  } catch (std::exception &e) {
+    cout << "Error: " << e.what() << endl;
+    return -1;
+  }
 }
 
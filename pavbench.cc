@@ -0,0 +1,320 @@
+//------------------------------------------------------------------------------
+//
+// Benchmarks for naive pavings enumerator
+//
+//------------------------------------------------------------------------------
+//
+// Runs naive_gen with every field representation and its hot components
+// over fixed matrix of field sizes and prints results as JSON:
+//
+//  {
+//    "naive_gen": [
+//      {"field": "Field", "n": 4, "m": 4, "seconds": ..., "search_space": ...,
+//       "pavings": ..., "search_space_per_sec": ..., "pavings_per_sec": ...,
+//       "allocs_per_run": ...},
+//      ...
+//    ],
+//    "components": [
+//      {"name": "Field::put", "n": 4, "m": 4, "ops": ..., "seconds": ...,
+//       "ops_per_sec": ..., "allocs_per_op": ...},
+//      ...
+//    ]
+//  }
+//
+// Search space is number of all mixed-radix tuples (count_ss), subtrees
+// pruned by search included, so search_space_per_sec is coverage rate, not
+// rate of visited tuples. Paving is tight paving found. Allocations are
+// counted by global operator new.
+//
+// Components are measured on all tight pavings of given size:
+//
+//  Field::put       -- placing all blocks of paving into empty field,
+//                      promote is private and is measured as part of put
+//  Field::push+pop  -- same with backtracking interface, then undo
+//  Field::tight     -- all() and tight() on filled field
+//  Field::vtype     -- vtype_scan() on filled field, signature included
+//  next_break_of    -- all partitions of n * m into n + m - 1 parts
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <new>
+#include <sstream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "bitfield.hpp"
+#include "btypes.hpp"
+#include "field.hpp"
+#include "hind.hpp"
+#include "pavgen.hpp"
+#include "pavio.hpp"
+
+using std::cout;
+using std::endl;
+using std::ostringstream;
+using std::pair;
+using std::string;
+using std::vector;
+
+static std::atomic<size_t> nallocs{0};
+
+// all replaceable forms, which go to malloc, so every new is counted and
+// every delete matches its new, aligned forms are left to the library
+// noinline keeps compiler from pairing malloc and free across them
+__attribute__((noinline)) void *counted_alloc(size_t sz) {
+  nallocs += 1;
+  return std::malloc(sz ? sz : 1);
+}
+
+__attribute__((noinline)) void counted_free(void *p) noexcept { std::free(p); }
+
+void *operator new(size_t sz) {
+  if (void *p = counted_alloc(sz))
+    return p;
+  throw std::bad_alloc();
+}
+
+void *operator new[](size_t sz) { return operator new(sz); }
+
+void *operator new(size_t sz, const std::nothrow_t &) noexcept {
+  return counted_alloc(sz);
+}
+
+void *operator new[](size_t sz, const std::nothrow_t &) noexcept {
+  return counted_alloc(sz);
+}
+
+void operator delete(void *p) noexcept { counted_free(p); }
+void operator delete[](void *p) noexcept { counted_free(p); }
+void operator delete(void *p, size_t) noexcept { counted_free(p); }
+void operator delete[](void *p, size_t) noexcept { counted_free(p); }
+
+void operator delete(void *p, const std::nothrow_t &) noexcept {
+  counted_free(p);
+}
+
+void operator delete[](void *p, const std::nothrow_t &) noexcept {
+  counted_free(p);
+}
+
+// any single measurement is repeated for at least this time
+constexpr double mintime = 0.2;
+
+struct measure {
+  double seconds = 0;
+  size_t reps = 0;
+  size_t allocs = 0;
+};
+
+template <typename F> measure timed(F f) {
+  using clock = std::chrono::steady_clock;
+  measure res;
+  size_t a0 = nallocs;
+  auto start = clock::now();
+  do {
+    f();
+    res.reps += 1;
+    res.seconds = std::chrono::duration<double>(clock::now() - start).count();
+  } while (res.seconds < mintime);
+  res.allocs = nallocs - a0;
+  return res;
+}
+
+// one JSON object per line, keys in order of addition
+class jsonrec {
+  ostringstream os_;
+  bool first_ = true;
+
+  void key(const char *k) {
+    os_ << (first_ ? "{" : ", ") << "\"" << k << "\": ";
+    first_ = false;
+  }
+
+public:
+  jsonrec &add(const char *k, const string &v) {
+    key(k);
+    os_ << "\"" << v << "\"";
+    return *this;
+  }
+
+  jsonrec &add(const char *k, double v) {
+    key(k);
+    os_ << v;
+    return *this;
+  }
+
+  jsonrec &add(const char *k, size_t v) {
+    key(k);
+    os_ << v;
+    return *this;
+  }
+
+  string str() const { return os_.str() + "}"; }
+};
+
+vector<string> gen_results, comp_results;
+
+volatile size_t sink;
+
+template <typename FieldT, typename TypesT>
+void bench_gen(const string &name, size_t N, size_t M) {
+  genconfig gcf;
+  gcf.only_stat = true;
+  genstat st;
+  auto ms = timed([&] { st = naive_stat<FieldT, TypesT>(N, M, gcf); });
+
+  double sec = ms.seconds / ms.reps;
+  jsonrec r;
+  r.add("field", name).add("n", N).add("m", M).add("seconds", sec);
+  r.add("search_space", st.count_ss).add("pavings", st.count_tp);
+  r.add("search_space_per_sec", st.count_ss / sec);
+  r.add("pavings_per_sec", st.count_tp / sec);
+  r.add("allocs_per_run", double(ms.allocs) / ms.reps);
+  gen_results.push_back(r.str());
+}
+
+void add_component(const string &name, size_t N, size_t M, size_t ops,
+                   measure ms) {
+  double total = double(ops) * ms.reps;
+  jsonrec r;
+  r.add("name", name).add("n", N).add("m", M).add("ops", ops);
+  r.add("seconds", ms.seconds / ms.reps);
+  r.add("ops_per_sec", total / ms.seconds);
+  r.add("allocs_per_op", ms.allocs / total);
+  comp_results.push_back(r.str());
+}
+
+// block sizes of paving in order of placement, restored from cells
+vector<pair<size_t, size_t>> paving_blocks(size_t N, size_t M,
+                                           const vector<size_t> &cells) {
+  vector<pair<size_t, size_t>> res;
+  vector<bool> seen(N * M + 1, false);
+  for (size_t pos = 0; pos < N * M; ++pos) {
+    size_t num = cells[pos];
+    if (seen[num])
+      continue;
+    seen[num] = true;
+    size_t h = 1, v = 1;
+    while ((pos % N + h < N) && (cells[pos + h] == num))
+      h += 1;
+    while ((pos / N + v < M) && (cells[pos + v * N] == num))
+      v += 1;
+    res.emplace_back(h, v);
+  }
+  return res;
+}
+
+void bench_components(size_t N, size_t M) {
+  // collect all tight pavings through binary output
+  const string tmpname =
+      (std::filesystem::temp_directory_path() / "pavbench.tpv").string();
+  genconfig gcf;
+  gcf.binout = tmpname;
+  naive_stat<BitField, BlockTypes>(N, M, gcf);
+
+  vector<vector<pair<size_t, size_t>>> pavings;
+  {
+    PavingReader rd(tmpname);
+    vector<size_t> cells;
+    while (rd.next(cells))
+      pavings.push_back(paving_blocks(N, M, cells));
+  }
+  std::remove(tmpname.c_str());
+
+  size_t nblocks = pavings.size() * (M + N - 1);
+  Field f(N, M);
+
+  auto ms = timed([&] {
+    for (auto &p : pavings) {
+      f.reset();
+      for (auto &b : p)
+        sink = f.put(b.first, b.second);
+    }
+  });
+  add_component("Field::put", N, M, nblocks, ms);
+
+  ms = timed([&] {
+    f.reset();
+    for (auto &p : pavings) {
+      for (auto &b : p)
+        sink = f.push(b.first, b.second);
+      for (size_t idx = 0; idx < p.size(); ++idx)
+        f.pop();
+    }
+  });
+  add_component("Field::push+pop", N, M, nblocks, ms);
+
+  vector<Field> filled;
+  for (auto &p : pavings) {
+    filled.emplace_back(N, M);
+    for (auto &b : p)
+      filled.back().put(b.first, b.second);
+  }
+
+  ms = timed([&] {
+    for (auto &ff : filled)
+      sink = ff.all() && ff.tight();
+  });
+  add_component("Field::tight", N, M, filled.size(), ms);
+
+  vtype_scratch vs;
+  ms = timed([&] {
+    for (auto &ff : filled)
+      if (ff.vtype_scan(vs))
+        sink = vs.signature.size();
+  });
+  add_component("Field::vtype", N, M, filled.size(), ms);
+
+  size_t n = N * M, m = N + M - 1, nparts = 0;
+  ms = timed([&] {
+    vector<size_t> a(m, 1);
+    a[m - 1] = n - m + 1;
+    nparts = 1;
+    while (next_break_of(n, m, a.begin(), a.end()))
+      nparts += 1;
+  });
+  add_component("next_break_of", N, M, nparts, ms);
+}
+
+template <size_t N, size_t M> void bench_size() {
+  bench_gen<Field, BlockTypes>("Field", N, M);
+  bench_gen<BitField, BlockTypes>("BitField", N, M);
+  bench_gen<FixedField<N, M>, FixedBlockTypes<N, M>>("FixedField", N, M);
+  bench_components(N, M);
+}
+
+void print_results(const char *name, const vector<string> &res, bool last) {
+  cout << "  \"" << name << "\": [" << endl;
+  for (size_t idx = 0; idx < res.size(); ++idx)
+    cout << "    " << res[idx] << ((idx + 1 < res.size()) ? "," : "") << endl;
+  cout << "  ]" << (last ? "" : ",") << endl;
+}
+
+int main() {
+  bench_size<3, 3>();
+  bench_size<4, 3>();
+  bench_size<3, 4>();
+  bench_size<4, 4>();
+  bench_size<5, 3>();
+  bench_size<5, 4>();
+  bench_size<4, 5>();
+  bench_size<6, 4>();
+  bench_size<5, 5>();
+
+  cout << "{" << endl;
+  print_results("naive_gen", gen_results, false);
+  print_results("components", comp_results, true);
+  cout << "}" << endl;
+}
@@ -0,0 +1,867 @@
+//------------------------------------------------------------------------------
+//
+// Naive pavings generator: enumeration engine of naivepavings
+//
+//------------------------------------------------------------------------------
+//
+// naive_gen<FieldT, TypesT>(N, M, gcf) lists all tight pavings of N x M field
+// and prints statistics, naive_stat does the same, but only returns
+// statistics, so it may be called from benchmarks and tests
+//
+// Long runs may be checkpointed: enumeration cursor and statistics so far
+// are periodically saved to text file, say
+//
+//  TPCHK1
+//  size 3 3 mode 0 0 1 shard 0 1
+//  stats 52 47 3 2 0 0
+//  genfunc 0
+//  units 10 done 10 1 1 0 0 0 0 0 0 0 0
+//  cursor 1 2 5 4 1 2 1 1 5 0 0 1 0 0
+//  offset 18
+//
+// Here mode is only_vtype, symmetric and binary output flags, vectors are
+// written as size and elements. Units 0 and 1 are done, unit 2 stopped at
+// permutation 4, 1, 2, 1, 1 right after tuple 0, 0, 1, 0, 0 (empty tuple
+// means permutation is not started yet). Offset is size of binary output.
+// Resumed run skips everything up to cursor, so its statistics and binary
+// output are the same as for uninterrupted run. Text output is flushed at
+// checkpoints, pavings after last checkpoint are printed again.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "btypes.hpp"
+#include "field.hpp"
+#include "hind.hpp"
+#include "mperm.hpp"
+#include "pavio.hpp"
+#include "symmetry.hpp"
+#include "workpool.hpp"
+
+using std::cout;
+using std::endl;
+using std::find;
+using std::function;
+using std::istream;
+using std::lock_guard;
+using std::make_unique;
+using std::map;
+using std::mutex;
+using std::next_permutation;
+using std::ostream;
+using std::ostringstream;
+using std::pair;
+using std::rotate;
+using std::sort;
+using std::string;
+using std::unique_ptr;
+
+struct genconfig {
+  bool only_stat = false;
+  bool no_stat = false;
+  bool only_vtype = false;
+  bool only_count = false;
+  bool symmetric = false;
+  bool transfer = false;
+  size_t nthreads = 1;
+  string binout;
+  string checkpoint;
+  double checkpoint_period = 600;
+  bool resume = false;
+  size_t shard = 0;
+  size_t nshards = 1;
+  string statout;
+};
+
+// statistics are additive, so every worker may collect its own and merge
+struct genstat {
+  size_t count_ss = 0;
+  size_t count_np = 0;
+  size_t count_nt = 0;
+  size_t count_tp = 0;
+  size_t count_vt = 0;
+  size_t count_sc = 0;
+  map<vector<size_t>, size_t> genfunc;
+
+  void merge(const genstat &rhs) {
+    count_ss += rhs.count_ss;
+    count_np += rhs.count_np;
+    count_nt += rhs.count_nt;
+    count_tp += rhs.count_tp;
+    count_vt += rhs.count_vt;
+    count_sc += rhs.count_sc;
+    for (auto g : rhs.genfunc)
+      genfunc[g.first] += g.second;
+  }
+
+  // text form: counters and genfunc as number of terms, each term is
+  // length, signature and coefficient
+  void write(ostream &os) const {
+    os << "stats " << count_ss << " " << count_np << " " << count_nt << " "
+       << count_tp << " " << count_vt << " " << count_sc << "\n";
+    os << "genfunc " << genfunc.size() << "\n";
+    for (auto &g : genfunc) {
+      os << g.first.size();
+      for (auto f : g.first)
+        os << " " << f;
+      os << " " << g.second << "\n";
+    }
+  }
+
+  void read(istream &is) {
+    string kw;
+    size_t nterms;
+    is >> kw >> count_ss >> count_np >> count_nt >> count_tp >> count_vt >>
+        count_sc;
+    if (!is || (kw != "stats"))
+      throw std::runtime_error("Wrong statistics format");
+    is >> kw >> nterms;
+    if (!is || (kw != "genfunc"))
+      throw std::runtime_error("Wrong statistics format");
+    genfunc.clear();
+    for (size_t idx = 0; idx < nterms; ++idx) {
+      size_t len;
+      is >> len;
+      vector<size_t> v(len);
+      for (auto &f : v)
+        is >> f;
+      is >> genfunc[v];
+    }
+    if (!is)
+      throw std::runtime_error("Wrong statistics format");
+  }
+};
+
+// where serial enumeration stopped: unit, permutation of its signature and
+// mixed-radix tuple of last visited leaf (empty if none visited yet)
+struct gencursor {
+  size_t unit = 0;
+  vector<size_t> bcnt;
+  vector<size_t> bmix;
+};
+
+// everything, that is saved to checkpoint
+struct genstate {
+  genstat st;
+  vector<bool> done;
+  bool has_cursor = false;
+  gencursor cur;
+  size_t offset = 0;
+};
+
+inline void write_sizes(ostream &os, const vector<size_t> &v) {
+  os << " " << v.size();
+  for (auto x : v)
+    os << " " << x;
+}
+
+inline void read_sizes(istream &is, vector<size_t> &v) {
+  size_t len = 0;
+  is >> len;
+  v.resize(len);
+  for (auto &x : v)
+    is >> x;
+}
+
+class GenCheckpoint {
+  using clock = std::chrono::steady_clock;
+  string fname_;
+  double period_;
+  clock::time_point last_;
+
+  // stamp of run: checkpoint is only valid for the same field and mode
+  static void write_mode(ostream &os, size_t N, size_t M, genconfig gcf) {
+    os << "size " << N << " " << M << " mode " << gcf.only_vtype << " "
+       << gcf.symmetric << " " << !gcf.binout.empty() << " shard "
+       << gcf.shard << " " << gcf.nshards << "\n";
+  }
+
+public:
+  GenCheckpoint(const string &fname, double period)
+      : fname_(fname), period_(period), last_(clock::now()) {}
+
+  bool due() const {
+    return std::chrono::duration<double>(clock::now() - last_).count() >=
+           period_;
+  }
+
+  // written to temporary file first, so killed run never leaves broken
+  // checkpoint behind
+  void save(size_t N, size_t M, genconfig gcf, const genstate &gs) {
+    string tmpname = fname_ + ".tmp";
+    {
+      std::ofstream os(tmpname);
+      os << "TPCHK1\n";
+      write_mode(os, N, M, gcf);
+      gs.st.write(os);
+      os << "units " << gs.done.size() << " done";
+      write_sizes(os, vector<size_t>(gs.done.begin(), gs.done.end()));
+      os << "\ncursor " << gs.has_cursor;
+      if (gs.has_cursor) {
+        os << " " << gs.cur.unit;
+        write_sizes(os, gs.cur.bcnt);
+        write_sizes(os, gs.cur.bmix);
+      }
+      os << "\noffset " << gs.offset << "\n";
+      if (!os.flush())
+        throw std::runtime_error("Can not write " + tmpname);
+    }
+    if (std::rename(tmpname.c_str(), fname_.c_str()) != 0)
+      throw std::runtime_error("Can not write " + fname_);
+    last_ = clock::now();
+  }
+
+  genstate load(size_t N, size_t M, genconfig gcf, size_t nunits) {
+    std::ifstream is(fname_);
+    if (!is)
+      throw std::runtime_error("Can not open " + fname_);
+
+    string kw, mode;
+    std::getline(is, kw);
+    std::getline(is, mode);
+    ostringstream expected;
+    write_mode(expected, N, M, gcf);
+    if ((kw != "TPCHK1") || (mode + "\n" != expected.str()))
+      throw std::runtime_error(fname_ + " is checkpoint of other run");
+
+    genstate gs;
+    gs.st.read(is);
+
+    size_t nu;
+    vector<size_t> done;
+    is >> kw >> nu;
+    if (kw != "units" || (nu != nunits))
+      throw std::runtime_error(fname_ + " is checkpoint of other run");
+    is >> kw;
+    read_sizes(is, done);
+    gs.done.assign(done.begin(), done.end());
+
+    is >> kw >> gs.has_cursor;
+    if (gs.has_cursor) {
+      is >> gs.cur.unit;
+      read_sizes(is, gs.cur.bcnt);
+      read_sizes(is, gs.cur.bmix);
+    }
+    is >> kw >> gs.offset;
+    if (!is || (kw != "offset") || (gs.done.size() != nunits))
+      throw std::runtime_error("Wrong checkpoint format in " + fname_);
+    return gs;
+  }
+};
+
+inline void print_genstat(const genstat &st, genconfig gcf) {
+  if (gcf.no_stat)
+    return;
+
+  // search space is cut by symmetries, so its statistics make no sense
+  // and transfer matrix has no search space at all
+  if (!gcf.only_count && gcf.symmetric) {
+    cout << "Statistics: " << endl;
+    cout << "Symmetry classes: " << st.count_sc << endl;
+  }
+  if (!gcf.only_count && gcf.transfer) {
+    cout << "Statistics: " << endl;
+  }
+  if (!gcf.only_count && !gcf.symmetric && !gcf.transfer) {
+    cout << "Statistics: " << endl;
+    cout << "Search space size: " << st.count_ss << endl;
+    cout << "Not a pavings: " << st.count_np << endl;
+    cout << "Not tight pavings: " << st.count_nt << endl;
+  }
+  cout << "Tight pavings: " << st.count_tp << endl;
+  if (!gcf.only_count) {
+    cout << "Vertical types: " << st.count_vt << endl;
+    cout << "Generation function: ";
+    for (auto g : st.genfunc) {
+      if (g != *st.genfunc.begin())
+        cout << "+";
+      if (g.second > 1)
+        cout << g.second;
+      for (auto f: g.first)
+        cout << "f" << f;      
+    }
+    cout << endl;
+  }
+}
+
+// Shard i of k enumerates only partitions i, i + k, i + 2k, ... of those
+// with allowed block areas (in RestrictedBreaks order), so k independent
+// runs cover all of them exactly once. Every shard writes its statistics
+// to file, say
+//
+//  TPSTAT1
+//  size 5 5 symmetric 0 shard 2 4
+//  stats 19577988 19294206 258312 25470 1580 0
+//  genfunc 28
+//  ...
+//
+// and merge_shard_stats adds them up, checking that all shards are present.
+inline void save_shard_stat(const string &fname, size_t N, size_t M,
+                            genconfig gcf, const genstat &st) {
+  std::ofstream os(fname);
+  os << "TPSTAT1\n";
+  os << "size " << N << " " << M << " symmetric " << gcf.symmetric
+     << " shard " << gcf.shard << " " << gcf.nshards << "\n";
+  st.write(os);
+  if (!os.flush())
+    throw std::runtime_error("Can not write " + fname);
+}
+
+inline genstat merge_shard_stats(const vector<string> &fnames, size_t N,
+                                 size_t M, bool &symmetric) {
+  genstat res;
+  vector<bool> seen;
+  for (auto &fname : fnames) {
+    std::ifstream is(fname);
+    if (!is)
+      throw std::runtime_error("Can not open " + fname);
+
+    string kw, ksize, ksym, kshard;
+    size_t n, m, shard, nshards;
+    bool sym;
+    is >> kw >> ksize >> n >> m >> ksym >> sym >> kshard >> shard >> nshards;
+    if (!is || (kw != "TPSTAT1") || (ksize != "size") ||
+        (ksym != "symmetric") || (kshard != "shard") || (shard >= nshards))
+      throw std::runtime_error(fname + " is not a statistics file");
+    if ((n != N) || (m != M))
+      throw std::runtime_error(fname + " is for other field size");
+
+    if (seen.empty()) {
+      seen.assign(nshards, false);
+      symmetric = sym;
+    }
+    if ((seen.size() != nshards) || (sym != symmetric))
+      throw std::runtime_error(fname + " is from other run");
+    if (seen[shard])
+      throw std::runtime_error(fname + " repeats shard " +
+                               std::to_string(shard));
+    seen[shard] = true;
+
+    genstat st;
+    st.read(is);
+    res.merge(st);
+  }
+
+  if (find(seen.begin(), seen.end(), false) != seen.end())
+    throw std::runtime_error("Some shards are missing");
+  return res;
+}
+
+// checkpoint hook: permutation and tuple to resume after
+using gentick = function<void(const vector<size_t> &, const vector<size_t> &)>;
+
+// depth-first search over mixed-radix tuples for one signature
+// tuples with common prefix share its placement, failed prefix discards
+// all tuples below it at once
+//
+// in symmetric mode only canonical pavings are visited, see symmetry.hpp
+// every canonical paving stands for its orbit
+template <typename FieldT, typename TypesT> struct paving_search {
+  size_t N, M;
+  const TypesT &btypes;
+  genconfig gcf;
+  genstat &st;
+  ostream &os;
+  PavingBuffer *pb;
+  FieldT f;
+  vector<size_t> bcnt;
+  vector<size_t> bmix;
+  vtype_scratch vs;
+
+  // checkpoint hook, called with permutation and tuple of last leaf once
+  // per 64K leaves and once per permutation
+  gentick on_tick;
+  size_t nticks = 0;
+
+  // maximal number of blocks placed at once in last run
+  size_t depth = 0;
+
+  // subtree[idx] is number of tuples for digits idx .. mback-1
+  vector<size_t> subtree;
+
+  // symmetries and shape of top left block for symmetric mode
+  vector<FieldSymmetry> syms;
+  pair<size_t, size_t> tlshape;
+
+  paving_search(size_t horz, size_t vert, const TypesT &bt, genconfig g,
+                genstat &s, ostream &o, PavingBuffer *b)
+      : N(horz), M(vert), btypes(bt), gcf(g), st(s), os(o),
+        pb(b), f(horz, vert) {
+    if (gcf.symmetric)
+      syms = field_symmetries(N, M);
+  }
+
+  // last is tuple of leaf, visited before checkpoint, or empty
+  void run(const vector<size_t> &signature,
+           const vector<size_t> &last = vector<size_t>{}) {
+    size_t mback = signature.size();
+    bcnt = signature;
+    bmix.assign(mback, 0);
+    subtree.assign(mback + 1, 1);
+    for (size_t idx = mback; idx > 0; --idx)
+      subtree[idx - 1] = subtree[idx] * btypes.count(bcnt[idx - 1]);
+    f.reset();
+    depth = 0;
+    if (last.empty()) {
+      descend(0);
+      return;
+    }
+    assert(last.size() == mback);
+    bmix = last;
+    resume(0);
+  }
+
+  void tick(const vector<size_t> &perm, const vector<size_t> &mix) {
+    if (on_tick && ((++nticks & 0xffff) == 0))
+      on_tick(perm, mix);
+  }
+
+  void descend(size_t idx) {
+    if (idx == bcnt.size()) {
+      leaf();
+      tick(bcnt, bmix);
+      return;
+    }
+
+    size_t nmix = btypes.count(bcnt[idx]);
+    for (size_t mix = 0; mix < nmix; ++mix)
+      step<false>(idx, mix);
+  }
+
+  // only tuples after bmix are visited: everything before and bmix itself
+  // are already in statistics
+  void resume(size_t idx) {
+    if (idx == bcnt.size())
+      return;
+
+    size_t nmix = btypes.count(bcnt[idx]);
+    size_t from = bmix[idx];
+    step<true>(idx, from);
+    for (size_t mix = from + 1; mix < nmix; ++mix)
+      step<false>(idx, mix);
+  }
+
+  // place variant mix of block idx and go deeper
+  template <bool Resuming> void step(size_t idx, size_t mix) {
+    bmix[idx] = mix;
+    auto elt = btypes.at(bcnt[idx], mix);
+    size_t start = f.next_cell();
+    if (!f.push(elt.first, elt.second)) {
+      // every tuple with this prefix is not a paving
+      st.count_ss += subtree[idx + 1];
+      st.count_np += subtree[idx + 1];
+      return;
+    }
+    if (idx >= depth)
+      depth = idx + 1;
+    if (idx == 0)
+      tlshape = elt;
+    if (!gcf.symmetric || may_be_canonical(start, elt)) {
+      if (Resuming)
+        resume(idx + 1);
+      else
+        descend(idx + 1);
+    }
+    f.pop();
+  }
+
+  // if block, just placed at start, goes to top left corner under some
+  // symmetry and becomes smaller than current top left one, no paving with
+  // this prefix is canonical
+  bool may_be_canonical(size_t start, pair<size_t, size_t> elt) {
+    size_t hpos = start % N, vpos = start / N;
+    for (auto &g : syms) {
+      auto src = g.source(N, M, 0, 0);
+      if ((src.first >= hpos) && (src.first < hpos + elt.first) &&
+          (src.second >= vpos) && (src.second < vpos + elt.second) &&
+          (g.shape(elt.first, elt.second) < tlshape))
+        return false;
+    }
+    return true;
+  }
+
+  void leaf() {
+    if (gcf.symmetric) {
+      leaf_symmetric();
+      return;
+    }
+
+    st.count_ss += 1;
+
+    if (!f.all()) {
+      st.count_np += 1;
+      return;
+    }
+
+    if (!f.tight()) {
+      st.count_nt += 1;
+      return;
+    }
+
+    st.count_tp += 1;
+    if (pb && !gcf.only_vtype)
+      pb->add(f);
+    else if (!gcf.only_stat && !gcf.only_vtype) {
+      f.dump(os);
+      os << endl;
+    }
+    if (f.vtype_scan(vs)) {
+      st.count_vt += 1;
+      auto &v = vs.signature;
+      if (pb && gcf.only_vtype)
+        pb->add(f);
+      else if (!gcf.only_stat && gcf.only_vtype) {
+        f.dump(os);
+        os << '\t';
+        for (auto s : v)
+          os << s << ' ';
+        os << endl;
+      }
+      sort(v.begin(), v.end());
+      st.genfunc[v] += 1;
+    }
+  }
+
+  // canonical paving is dumped with its orbit size, vtype statistics
+  // are collected over whole orbit
+  void leaf_symmetric() {
+    if (!f.all() || !f.tight())
+      return;
+
+    vector<size_t> cells(N * M);
+    f.copy_cells(cells.begin());
+    vector<vector<size_t>> orbit{cells};
+    for (auto &g : syms) {
+      auto img = symmetric_cells(g, N, M, cells);
+      if (paving_less(N, M, img, cells))
+        return;
+      if (find(orbit.begin(), orbit.end(), img) == orbit.end())
+        orbit.push_back(img);
+    }
+
+    st.count_sc += 1;
+    st.count_tp += orbit.size();
+    if (pb && !gcf.only_vtype)
+      pb->add(f, orbit.size());
+    else if (!gcf.only_stat && !gcf.only_vtype) {
+      f.dump(os);
+      os << '\t' << orbit.size() << endl;
+    }
+
+    for (auto &img : orbit) {
+      if (!cells_vtype_scan(N, M, img, M + N, vs))
+        continue;
+      st.count_vt += 1;
+      auto &v = vs.signature;
+      if (pb && gcf.only_vtype)
+        pb->add_cells(img);
+      else if (!gcf.only_stat && gcf.only_vtype) {
+        cells_dump(os, N, M, img);
+        os << '\t';
+        for (auto s : v)
+          os << s << ' ';
+        os << endl;
+      }
+      sort(v.begin(), v.end());
+      st.genfunc[v] += 1;
+    }
+  }
+};
+
+// process one work unit: signature with fixed first element
+// all permutations of the tail are visited in lexicographic order, so
+// visiting units in order of creation is the same as permuting whole
+// signature at once
+//
+// from is cursor inside this unit to resume from, on_tick is checkpoint
+// hook, see paving_search
+//
+// if no tuple of signature got past block d, result depends only on areas
+// 0 .. d: every next permutation with the same prefix fails the same way
+// and adds the same counts, so they are all skipped at once
+template <typename FieldT, typename TypesT>
+void gen_unit(size_t N, size_t M, const TypesT &btypes,
+              const vector<size_t> &unit,
+              genconfig gcf, genstat &st, ostream &os, PavingBuffer *pb,
+              const gencursor *from = nullptr,
+              gentick on_tick = gentick{}) {
+  paving_search<FieldT, TypesT> ps(N, M, btypes, gcf, st, os, pb);
+  ps.on_tick = on_tick;
+
+  vector<size_t> resume;
+  vector<size_t> bcnt = from ? from->bcnt : unit;
+  if (from)
+    resume = from->bmix;
+  MultisetPerm<size_t> tail(vector<size_t>(bcnt.begin() + 1, bcnt.end()));
+
+  for (;;) {
+    // 3. for given signature generate all mixed-radix tuples
+    //    say for 2, 1, 1, 2, 3
+    //    btypes.count(1) == 1, btypes.count(2) == 2, btypes.count(3) == 2
+    //    solutions are:
+    //
+    //    0, 0, 0, 0, 0
+    //    0, 0, 0, 0, 1
+    //    0, 0, 0, 1, 0
+    //    0, 0, 0, 1, 1
+    //    1, 0, 0, 0, 0
+    //    1, 0, 0, 0, 1
+    //    1, 0, 0, 1, 0
+    //    1, 0, 0, 1, 1
+    //
+    // 4. for mixed-radix tuple and signature fill field with btypes.at(i, j)
+    //    blocks
+    //    filter out non-pavings
+    //    filter-out non-tight pavings
+    //
+    //    tuples are visited in the same order, but as a tree: digit idx
+    //    is tried only when blocks 0 .. idx-1 are already placed
+
+    size_t ss = st.count_ss, np = st.count_np;
+    bool resumed = !resume.empty();
+    ps.run(bcnt, resume);
+    resume.clear();
+
+    bool more;
+    if (!resumed && (ps.depth < bcnt.size())) {
+      size_t skipped = tail.rest(ps.depth);
+      st.count_ss += (st.count_ss - ss) * skipped;
+      st.count_np += (st.count_np - np) * skipped;
+      more = tail.skip_prefix(ps.depth);
+    } else
+      more = tail.next();
+    if (!more)
+      break;
+    copy(tail.begin(), tail.end(), bcnt.begin() + 1);
+
+    // next permutation is not started yet, hook is called every time,
+    // not through leaf counter of ps
+    if (on_tick)
+      on_tick(bcnt, resume);
+  }
+}
+
+// FieldT is field representation: Field, BitField or FixedField<N, M>
+// TypesT is block types table: BlockTypes or FixedBlockTypes<N, M>
+template <typename FieldT, typename TypesT = BlockTypes>
+genstat naive_stat(size_t N, size_t M, genconfig gcf) {
+  // 1. enumerate possible block types
+  //    (1 .. M-1) x (1 .. N-1) + 1 x N + 1 x M
+  //   say 2:1 and 1:2 both have counter 2
+  //
+  //   btypes.count(2) == 2
+  //   btypes.at(2, 0) = <1, 2>
+  //   btypes.at(2, 1) = <2, 1>
+  //
+  //   see btypes.hpp for details
+
+  TypesT btypes(N, M);
+
+  // 2. generate all type signatures of M+N-1 buckets
+  //    with discrete allowed number of balls in each
+  //
+  //    n is allowed <=> btypes.count(n) != 0
+  //    1 is always allowed (1x1 block)
+  //
+  //    say for M*N = 9 and allowed numbers 1, 2, 3, 4
+  //    possible signatures:
+  //
+  //    1, 1, 1, 2, 4
+  //    1, 1, 1, 3, 3
+  //    1, 1, 2, 2, 3
+  //    1, 2, 2, 2, 2
+  //
+  //    and all permutations
+
+  size_t bsize = 1;
+  for (size_t cnt = 2; cnt <= btypes.maxarea(); ++cnt)
+    if (btypes.count(cnt) > 0)
+      bsize = cnt;
+
+  size_t mback = (M + N - 1);
+  size_t nballs = M * N;
+  vector<size_t> bcnt(mback, 1);
+  size_t excessballs = nballs - mback;
+
+  // form minimal signature 1, 1 ... 1, r, n ... n
+  // 2x2: 1, 1, 2
+  // 2x3: 1, 1, 1, 3
+  // 3x3: 1, 1, 1, 2, 4
+  // 4x3: 1, 1, 1, 1, 2, 6
+  // 4x4: 1, 1, 1, 1, 1, 2, 9
+  // suppose that r is always available number. As shown above it is always true
+  // for small numbers, but general case shall be proven separately, I think
+
+  size_t curback = mback - 1;
+  while (excessballs > 0) {
+    if (excessballs > bsize - 1) {
+      bcnt[curback] = bsize;
+      excessballs -= (bsize - 1);
+      assert(curback > 0);
+      curback -= 1;
+    } else {
+      assert(btypes.count(excessballs + 1) > 0);
+      assert(bcnt[curback] == 1);
+      bcnt[curback] += excessballs;
+      excessballs = 0;
+    }
+  }
+
+  // split signatures into work units by leading block area
+  // say 1, 1, 2, 4 gives units 1|1, 2, 4 and 2|1, 1, 4 and 4|1, 1, 2
+  // only partitions of given shard are taken
+  //
+  // only allowed areas are ever generated, so partitions with disallowed
+  // area are skipped by whole subtrees, minimal signature is the first
+  vector<vector<size_t>> units;
+  size_t npart = 0;
+
+  vector<unsigned char> allowed(nballs + 1);
+  for (size_t area = 1; area <= nballs; ++area)
+    allowed[area] = (btypes.count(area) > 0);
+
+  RestrictedBreaks rb(nballs, mback, allowed);
+  do {
+    if (npart++ % gcf.nshards != gcf.shard)
+      continue;
+
+    for (size_t lead = 0; lead < mback; ++lead) {
+      if ((lead > 0) && (bcnt[lead] == bcnt[lead - 1]))
+        continue;
+      vector<size_t> unit = bcnt;
+      rotate(unit.begin(), unit.begin() + lead, unit.begin() + lead + 1);
+      units.push_back(unit);
+    }
+  } while (rb.next(bcnt.begin(), bcnt.end()));
+
+  genstate gs;
+  gs.done.assign(units.size(), false);
+  unique_ptr<GenCheckpoint> cp;
+  if (!gcf.checkpoint.empty()) {
+    cp = make_unique<GenCheckpoint>(gcf.checkpoint, gcf.checkpoint_period);
+    if (gcf.resume)
+      gs = cp->load(N, M, gcf, units.size());
+  }
+
+  // parallel checkpoints are per unit and units are written to binary
+  // output in pieces, so there is no consistent offset
+  if (cp && !gcf.binout.empty() && (gcf.nthreads > 1))
+    throw std::runtime_error("Checkpoints with binary output need serial run");
+
+  // binary output goes through per-thread buffers
+  // symmetric run writes only canonical pavings, so they go with weights
+  unique_ptr<PavingWriter> pw;
+  vector<unique_ptr<PavingBuffer>> pbs(gcf.nthreads);
+  if (!gcf.binout.empty()) {
+    bool weighted = gcf.symmetric && !gcf.only_vtype;
+    pw = make_unique<PavingWriter>(gcf.binout, N, M, gs.offset, weighted);
+    for (auto &pb : pbs)
+      pb = make_unique<PavingBuffer>(*pw);
+  }
+
+  // all output before checkpoint shall be flushed
+  // with binary output run is serial, so there is only one buffer
+  auto save = [&] {
+    cout.flush();
+    if (pw) {
+      pbs[0]->flush();
+      gs.offset = pw->tell();
+    }
+    cp->save(N, M, gcf, gs);
+  };
+
+  if (gcf.nthreads < 2) {
+    for (size_t u = 0; u < units.size(); ++u) {
+      if (gs.done[u])
+        continue;
+
+      gentick tick;
+      if (cp)
+        tick = [&, u](const vector<size_t> &perm, const vector<size_t> &mix) {
+          if (!cp->due())
+            return;
+          gs.has_cursor = true;
+          gs.cur = gencursor{u, perm, mix};
+          save();
+        };
+
+      bool from = gs.has_cursor && (gs.cur.unit == u);
+      gen_unit<FieldT, TypesT>(N, M, btypes, units[u], gcf, gs.st, cout,
+                               pbs[0].get(), from ? &gs.cur : nullptr, tick);
+      gs.done[u] = true;
+      gs.has_cursor = false;
+      if (cp && cp->due())
+        save();
+    }
+  } else {
+    // per-unit statistics, output is collected per unit and written
+    // in one piece, so pavings are not interleaved but come in any order
+    // cursor of serial checkpoint is kept until its unit is done
+    mutex outmut;
+    size_t curunit = gs.has_cursor ? gs.cur.unit : units.size();
+    StealingPool<size_t> pool(gcf.nthreads);
+    for (size_t u = 0; u < units.size(); ++u)
+      if (!gs.done[u])
+        pool.push(u);
+    pool.run([&](size_t tid, size_t &u) {
+      ostringstream os;
+      genstat ust;
+      gen_unit<FieldT, TypesT>(N, M, btypes, units[u], gcf, ust, os,
+                               pbs[tid].get(),
+                               (u == curunit) ? &gs.cur : nullptr);
+      lock_guard<mutex> lk(outmut);
+      if (!gcf.only_stat && !pw)
+        cout << os.str();
+      gs.st.merge(ust);
+      gs.done[u] = true;
+      if (u == curunit)
+        gs.has_cursor = false;
+      if (cp && cp->due())
+        save();
+    });
+  }
+
+  // last checkpoint has everything done, so resume only prints results
+  if (cp)
+    save();
+
+  // buffers shall be flushed before writer is closed, both may throw
+  if (pw) {
+    for (auto &pb : pbs)
+      pb->flush();
+    pw->close();
+  }
+
+  // 5. return result
+  return gs.st;
+}
+
+template <typename FieldT, typename TypesT = BlockTypes>
+size_t naive_gen(size_t N, size_t M, genconfig gcf) {
+  genstat st = naive_stat<FieldT, TypesT>(N, M, gcf);
+  if (!gcf.statout.empty())
+    save_shard_stat(gcf.statout, N, M, gcf, st);
+  print_genstat(st, gcf);
+  return st.count_tp;
+}
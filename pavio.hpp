@@ -0,0 +1,262 @@
+//------------------------------------------------------------------------------
+//
+//  Binary format for tight pavings
+//
+//------------------------------------------------------------------------------
+//
+// File is 8-byte header followed by fixed-width records
+//
+//  'T' 'P' 'V' K N M W0 W1
+//
+// where W = W0 + 256 * W1 is record width in bytes. Record is block numbers
+// of N * M cells, row by row, packed in nibbles, low nibble first. Say 3x2
+// paving 122|344 is
+//
+//  0x21 0x32 0x44
+//
+// K is kind of file:
+//
+//  '1' -- every record is one paving
+//  'W' -- weighted, every record is canonical paving of symmetry class
+//         (naivepavings -y) followed by one byte of its orbit size, so
+//         number of pavings is sum of weights
+//
+// Block numbers are 1 .. M + N - 1, so nibbles work only for M + N <= 16,
+// which is way beyond anything we can enumerate.
+//
+// Writer is shared between threads, each thread packs records into its
+// own PavingBuffer and only full buffers are written under lock. Write
+// errors are exceptions, so buffers are not flushed by destructors: every
+// buffer shall be flushed and then writer closed explicitly, whatever is
+// left is dropped.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+constexpr size_t paving_header_size = 8;
+constexpr size_t paving_buffer_size = 1 << 22;
+
+inline size_t paving_width(size_t N, size_t M, bool weighted = false) {
+  return (N * M + 1) / 2 + (weighted ? 1 : 0);
+}
+
+class PavingWriter {
+  std::FILE *f_;
+  size_t N, M;
+  bool weighted_;
+  std::mutex mut_;
+
+  // helper: continued file is cut to offset, where it was consistent
+  // everything is checked before file is touched, so wrong call neither
+  // creates nor truncates it
+  static std::FILE *open(const std::string &fname, size_t N, size_t M,
+                         size_t offset, bool weighted) {
+    if (N + M > 16)
+      throw std::runtime_error("Binary output is only for N + M <= 16");
+    size_t w = paving_width(N, M, weighted);
+    if ((offset != 0) && ((offset < paving_header_size) ||
+                          ((offset - paving_header_size) % w != 0)))
+      throw std::runtime_error(fname + " has wrong offset to continue");
+    if (offset == 0)
+      return std::fopen(fname.c_str(), "wb");
+    std::filesystem::resize_file(fname, offset);
+    return std::fopen(fname.c_str(), "ab");
+  }
+
+public:
+  // offset != 0 continues file, which was written up to offset before
+  PavingWriter(const std::string &fname, size_t horz, size_t vert,
+               size_t offset = 0, bool weighted = false)
+      : f_(open(fname, horz, vert, offset, weighted)), N(horz), M(vert),
+        weighted_(weighted) {
+    if (!f_)
+      throw std::runtime_error("Can not open " + fname);
+    if (offset != 0)
+      return;
+    size_t w = paving_width(N, M, weighted_);
+    unsigned char hdr[paving_header_size] = {
+        'T',
+        'P',
+        'V',
+        static_cast<unsigned char>(weighted_ ? 'W' : '1'),
+        static_cast<unsigned char>(N),
+        static_cast<unsigned char>(M),
+        static_cast<unsigned char>(w & 0xff),
+        static_cast<unsigned char>(w >> 8)};
+    if (std::fwrite(hdr, 1, paving_header_size, f_) != paving_header_size) {
+      std::fclose(f_);
+      throw std::runtime_error("Can not write header to " + fname);
+    }
+  }
+
+  PavingWriter(const PavingWriter &) = delete;
+  PavingWriter &operator=(const PavingWriter &) = delete;
+
+  ~PavingWriter() {
+    if (f_)
+      std::fclose(f_);
+  }
+
+  // last buffered data is written here, so result shall be checked
+  void close() {
+    std::lock_guard<std::mutex> lk(mut_);
+    std::FILE *f = f_;
+    f_ = nullptr;
+    if (std::fclose(f) != 0)
+      throw std::runtime_error("Binary output close failed");
+  }
+
+  size_t horz() const { return N; }
+  size_t vert() const { return M; }
+  bool weighted() const { return weighted_; }
+
+  void write(const unsigned char *data, size_t len) {
+    std::lock_guard<std::mutex> lk(mut_);
+    if (std::fwrite(data, 1, len, f_) != len)
+      throw std::runtime_error("Binary output write failed");
+  }
+
+  void flush() {
+    std::lock_guard<std::mutex> lk(mut_);
+    if (std::fflush(f_) != 0)
+      throw std::runtime_error("Binary output write failed");
+  }
+
+  // bytes written so far
+  size_t tell() {
+    std::lock_guard<std::mutex> lk(mut_);
+    if (std::fflush(f_) != 0)
+      throw std::runtime_error("Binary output write failed");
+    return std::ftell(f_);
+  }
+};
+
+class PavingBuffer {
+  PavingWriter &w_;
+  size_t ncells_;
+  std::vector<unsigned char> buf_;
+
+public:
+  PavingBuffer(PavingWriter &w) : w_(w), ncells_(w.horz() * w.vert()) {
+    buf_.reserve(paving_buffer_size);
+  }
+
+  PavingBuffer(const PavingBuffer &) = delete;
+  PavingBuffer &operator=(const PavingBuffer &) = delete;
+
+  // F is any field with copy_cells
+  // weight is orbit size, only weighted files have weights other than 1
+  template <typename F> void add(const F &f, size_t weight = 1) {
+    std::array<unsigned char, 64> cells{};
+    f.copy_cells(cells.begin());
+    add_cells(cells, weight);
+  }
+
+  // C is random access block numbers, row by row
+  template <typename C> void add_cells(const C &cells, size_t weight = 1) {
+    for (size_t idx = 0; idx < ncells_; idx += 2) {
+      unsigned char hi = (idx + 1 < ncells_) ? cells[idx + 1] : 0;
+      buf_.push_back(cells[idx] | (hi << 4));
+    }
+    if (w_.weighted()) {
+      assert((weight >= 1) && (weight <= 255));
+      buf_.push_back(static_cast<unsigned char>(weight));
+    } else
+      assert(weight == 1);
+    size_t w = paving_width(w_.horz(), w_.vert(), w_.weighted());
+    if (buf_.size() + w > paving_buffer_size)
+      flush();
+  }
+
+  void flush() {
+    if (!buf_.empty())
+      w_.write(buf_.data(), buf_.size());
+    buf_.clear();
+  }
+};
+
+class PavingReader {
+  std::FILE *f_;
+  size_t N = 0, M = 0, width_ = 0;
+  bool weighted_ = false;
+  size_t weight_ = 1;
+  std::vector<unsigned char> buf_;
+  size_t pos_ = 0;
+
+  void refill() {
+    size_t rest = buf_.size() - pos_;
+    std::copy(buf_.begin() + pos_, buf_.end(), buf_.begin());
+    buf_.resize(paving_buffer_size);
+    size_t got = std::fread(buf_.data() + rest, 1, buf_.size() - rest, f_);
+    buf_.resize(rest + got);
+    pos_ = 0;
+  }
+
+public:
+  PavingReader(const std::string &fname)
+      : f_(std::fopen(fname.c_str(), "rb")) {
+    if (!f_)
+      throw std::runtime_error("Can not open " + fname);
+    unsigned char hdr[paving_header_size];
+    if ((std::fread(hdr, 1, paving_header_size, f_) != paving_header_size) ||
+        (hdr[0] != 'T') || (hdr[1] != 'P') || (hdr[2] != 'V') ||
+        ((hdr[3] != '1') && (hdr[3] != 'W')))
+      throw std::runtime_error(fname + " is not a paving file");
+    weighted_ = (hdr[3] == 'W');
+    N = hdr[4];
+    M = hdr[5];
+    width_ = hdr[6] + (hdr[7] << 8);
+    if (width_ != paving_width(N, M, weighted_))
+      throw std::runtime_error(fname + " has wrong record width");
+  }
+
+  PavingReader(const PavingReader &) = delete;
+  PavingReader &operator=(const PavingReader &) = delete;
+
+  ~PavingReader() { std::fclose(f_); }
+
+  size_t horz() const { return N; }
+  size_t vert() const { return M; }
+
+  // records are symmetry classes with weights
+  bool weighted() const { return weighted_; }
+
+  // orbit size of last record, 1 for not weighted file
+  size_t weight() const { return weight_; }
+
+  // unpack next record into N * M block numbers
+  bool next(std::vector<size_t> &cells) {
+    if (buf_.size() - pos_ < width_) {
+      refill();
+      if (buf_.empty())
+        return false;
+      if (buf_.size() < width_)
+        throw std::runtime_error("Truncated paving file");
+    }
+    cells.resize(N * M);
+    for (size_t idx = 0; idx < N * M; ++idx) {
+      unsigned char b = buf_[pos_ + idx / 2];
+      cells[idx] = (idx % 2) ? (b >> 4) : (b & 0xf);
+    }
+    if (weighted_)
+      weight_ = buf_[pos_ + width_ - 1];
+    pos_ += width_;
+    return true;
+  }
+};
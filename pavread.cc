@@ -0,0 +1,79 @@
+//------------------------------------------------------------------------------
+//
+// Paving reader: decodes binary output of naivepavings -o
+//
+//------------------------------------------------------------------------------
+//
+// Prints pavings in the same text format as naivepavings does, say
+//
+//   122|334|335
+//
+// or only counts them with -c
+//
+// File of symmetry classes (naivepavings -y -o file) has orbit size of every
+// canonical paving, it is printed after tab, again as naivepavings does, and
+// -c counts both classes and pavings
+//
+//------------------------------------------------------------------------------
+
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include "field.hpp"
+#include "pavio.hpp"
+
+using std::cout;
+using std::endl;
+using std::strcmp;
+using std::vector;
+
+void printusage(char *argv0) {
+  cout << "Usage: " << argv0 << " file [-c]" << endl;
+  cout << "\tWhere file is produced by naivepavings -o file" << endl;
+  cout << "Options supported are:" << endl;
+  cout << "\t-c -- only count pavings" << endl;
+}
+
+int main(int argc, char **argv) {
+  if ((argc < 2) || (argc > 3)) {
+    printusage(argv[0]);
+    return -1;
+  }
+
+  bool only_count = false;
+  if (argc == 3) {
+    if (strcmp(argv[2], "-c") != 0) {
+      printusage(argv[0]);
+      return -1;
+    }
+    only_count = true;
+  }
+
+  try {
+    PavingReader pr(argv[1]);
+    size_t N = pr.horz();
+    size_t M = pr.vert();
+    vector<size_t> cells;
+    size_t count = 0, classes = 0;
+
+    while (pr.next(cells)) {
+      classes += 1;
+      count += pr.weight();
+      if (only_count)
+        continue;
+      cells_dump(cout, N, M, cells);
+      if (pr.weighted())
+        cout << '\t' << pr.weight();
+      cout << "\n";
+    }
+
+    if (only_count && pr.weighted())
+      cout << "Symmetry classes: " << classes << endl;
+    if (only_count)
+      cout << "Pavings: " << count << endl;
+  } catch (std::exception &e) {
+    cout << "Error: " << e.what() << endl;
+    return -1;
+  }
+}
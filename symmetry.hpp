@@ -0,0 +1,115 @@
+//------------------------------------------------------------------------------
+//
+//  Symmetries of rectangular field
+//
+//------------------------------------------------------------------------------
+//
+// Any symmetry of N x M rectangle is composition of optional flip of x,
+// optional flip of y and (only for N == M) optional transposition. So there
+// are 4 symmetries for rectangle and 8 for square.
+//
+// Image of paving is relabeled, so blocks are numbered in order of first
+// occurrence, just like Field numbers them. Say for 3x2 horizontal flip
+//
+//  122    221    122
+//  334 -> 433 -> 344
+//
+// is the same paving and
+//
+//  112    211    122
+//  342 -> 243 -> 134
+//
+// is not.
+//
+// Canonical paving is least one in its orbit: first by shape of top left
+// block, then lexicographically by relabeled cells. Comparing top left block
+// first allows to discard paving as soon as some other corner is known to be
+// smaller.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cassert>
+#include <utility>
+#include <vector>
+
+struct FieldSymmetry {
+  bool transpose, flipx, flipy;
+
+  // cell of original paving, which goes to (x, y) of image
+  std::pair<size_t, size_t> source(size_t N, size_t M, size_t x,
+                                   size_t y) const {
+    if (flipx)
+      x = N - 1 - x;
+    if (flipy)
+      y = M - 1 - y;
+    if (transpose)
+      return {y, x};
+    return {x, y};
+  }
+
+  // block shape <h, v> in image
+  std::pair<size_t, size_t> shape(size_t hlen, size_t vlen) const {
+    if (transpose)
+      return {vlen, hlen};
+    return {hlen, vlen};
+  }
+};
+
+// all symmetries but identity
+inline std::vector<FieldSymmetry> field_symmetries(size_t N, size_t M) {
+  std::vector<FieldSymmetry> res;
+  for (int t = 0; t < ((N == M) ? 2 : 1); ++t)
+    for (int fx = 0; fx < 2; ++fx)
+      for (int fy = 0; fy < 2; ++fy)
+        if (t || fx || fy)
+          res.push_back(FieldSymmetry{t == 1, fx == 1, fy == 1});
+  return res;
+}
+
+// relabeled image of cells
+template <typename C>
+std::vector<size_t> symmetric_cells(const FieldSymmetry &g, size_t N,
+                                    size_t M, const C &cells) {
+  std::vector<size_t> res(N * M), relabel(N * M + 1, 0);
+  size_t next = 1;
+  for (size_t y = 0; y < M; ++y)
+    for (size_t x = 0; x < N; ++x) {
+      auto src = g.source(N, M, x, y);
+      auto num = cells[src.second * N + src.first];
+      if (relabel[num] == 0)
+        relabel[num] = next++;
+      res[y * N + x] = relabel[num];
+    }
+  return res;
+}
+
+// shape <h, v> of top left block
+template <typename C>
+std::pair<size_t, size_t> corner_shape(size_t N, size_t M, const C &cells) {
+  size_t h = 1, v = 1;
+  while ((h < N) && (cells[h] == cells[0]))
+    h += 1;
+  while ((v < M) && (cells[v * N] == cells[0]))
+    v += 1;
+  return {h, v};
+}
+
+// strict order on pavings: top left block first, cells next
+template <typename C1, typename C2>
+bool paving_less(size_t N, size_t M, const C1 &lhs, const C2 &rhs) {
+  auto ls = corner_shape(N, M, lhs);
+  auto rs = corner_shape(N, M, rhs);
+  if (ls != rs)
+    return ls < rs;
+  for (size_t idx = 0; idx < N * M; ++idx)
+    if (lhs[idx] != rhs[idx])
+      return lhs[idx] < rhs[idx];
+  return false;
+}
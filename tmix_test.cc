@@ -1,7 +1,84 @@
+#include <algorithm>
+#include <cassert>
 #include <iostream>
+#include <set>
+#include <vector>
 
 #include "tuples_mixed.hpp"
 
+// every tuple exactly once, one digit by one per step, twice: forth and back
+void test_gray(std::vector<int> radices) {
+  size_t total = 1;
+  for (auto r : radices)
+    total *= r;
+
+  GrayModeTuple gt(radices.begin(), radices.end());
+  std::vector<int> prev(gt.begin(), gt.end());
+  assert(gt.changed() == -1);
+  for (int pass = 0; pass < 2; ++pass) {
+    std::set<std::vector<int>> seen;
+    do {
+      std::vector<int> cur(gt.begin(), gt.end());
+      if (!seen.empty()) {
+        int p = gt.changed();
+        assert(p >= 0 && p < int(cur.size()));
+        assert(gt.delta() == 1 || gt.delta() == -1);
+        for (size_t j = 0; j < cur.size(); ++j)
+          assert(cur[j] == prev[j] + ((int(j) == p) ? gt.delta() : 0));
+      }
+      for (size_t j = 0; j < cur.size(); ++j)
+        assert(cur[j] >= 0 && cur[j] < radices[j]);
+      assert(seen.insert(cur).second);
+      prev = cur;
+    } while (gt.next_tuple());
+    assert(seen.size() == total);
+  }
+}
+
+// rank shall count next_tuple steps, unrank and advance shall agree
+void test_rank(std::vector<int> radices) {
+  MixedModeTuple mt(radices.begin(), radices.end());
+  MixedModeTuple other(radices.begin(), radices.end());
+  size_t total = mt.count(), idx = 0;
+  do {
+    assert(mt.rank() == idx);
+    other.unrank(idx);
+    assert(std::equal(mt.begin(), mt.end(), other.begin()));
+
+    for (size_t k = 0; k <= total + 1; k += 3) {
+      other.unrank(idx);
+      bool inside = other.advance(k);
+      assert(inside == (idx + k < total));
+      assert(other.rank() == (idx + k) % total);
+    }
+    idx += 1;
+  } while (mt.next_tuple());
+  assert(idx == total);
+}
+
+// batches shall be columns of next_tuple walk, from any start
+void test_batch(std::vector<int> radices, size_t k, size_t start) {
+  MixedModeTuple mt(radices.begin(), radices.end());
+  MixedModeTuple bt(radices.begin(), radices.end());
+  mt.unrank(start);
+  bt.unrank(start);
+  std::vector<int> buf(k * radices.size());
+  size_t total = start, cnt;
+  bool more;
+  do {
+    more = bt.next_batch(buf.begin(), k, cnt);
+    assert(cnt > 0 && cnt <= k);
+    for (size_t i = 0; i < cnt; ++i) {
+      for (size_t j = 0; j < radices.size(); ++j)
+        assert(buf[j * k + i] == mt.begin()[j]);
+      mt.next_tuple();
+    }
+    total += cnt;
+    assert(std::equal(mt.begin(), mt.end(), bt.begin()));
+  } while (more);
+  assert(total == mt.count());
+}
+
 int main () {
   int numbers[] = {6, 5, 4};
 
@@ -19,4 +96,30 @@ int main () {
       std::cout << *it << " ";
     std::cout << std::endl;
   } while(mt.next_tuple());
+
+  std::cout << "gray code" << std::endl;
+  GrayModeTuple gt(std::begin(numbers), std::end(numbers));
+  do {
+    for (auto it = gt.begin(); it != gt.end(); ++it)
+      std::cout << *it << " ";
+    std::cout << std::endl;
+  } while(gt.next_tuple());
+
+  test_rank({6, 5, 4});
+  test_rank({1, 3, 1, 2});
+  test_rank({7});
+
+  for (size_t k = 1; k <= 9; ++k)
+    for (size_t start = 0; start < 120; start += 17) {
+      test_batch({6, 5, 4}, k, start);
+      test_batch({1, 3, 1, 2, 2}, k, start % 12);
+    }
+  test_batch({2, 2, 2, 2, 2, 2, 2, 2, 2, 2}, 256, 0);
+
+  test_gray({2, 3});
+  test_gray({6, 5, 4});
+  test_gray({1, 3, 1, 2, 1});
+  test_gray({2, 2, 2, 2, 2});
+  test_gray({1});
+  test_gray({7});
 }
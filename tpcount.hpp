@@ -0,0 +1,207 @@
+//------------------------------------------------------------------------------
+//
+//  Transfer matrix counting of tight pavings
+//
+//------------------------------------------------------------------------------
+//
+// Field is swept column by column. After column x state is:
+//
+//  cuts    -- how column x is cut into blocks: bit i is set if rows i and
+//             i + 1 belong to different blocks
+//  hused   -- horizontal lines, which are bottom edges of some block, that is
+//             union of cuts of all columns so far
+//  nblocks -- number of blocks so far
+//  vflag   -- paving still may be vtype
+//  sig     -- multiset of blocks per column (vtype signature), packed by
+//             4 bits per value, only when vflag is set
+//
+// Say for 3x3 paving 122|322|345 state after column 1 is
+//
+//  cuts = 0b10, hused = 0b11, nblocks = 4, sig = {2, 2}
+//
+// Step to column x + 1 ends some blocks of column x (at least one, because
+// vertical line x + 1 shall be used) and cuts every run of ended rows into
+// new blocks in every possible way. New block with exactly the same rows as
+// ended one is adjacent to it with the same vertical extent, so paving is
+// not vtype.
+//
+// Tight paving is final state with all horizontal lines used and with
+// M + N - 1 blocks. Number of states is at most 4^(M-1) * (M + N) * (vtype
+// states), so it works for much larger fields than direct enumeration.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <cassert>
+#include <cstdint>
+#include <map>
+#include <stdexcept>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+struct tpcounts {
+  size_t count_tp = 0;
+  size_t count_vt = 0;
+  std::map<std::vector<size_t>, size_t> genfunc;
+};
+
+struct tpstate {
+  uint64_t lo; // cuts | hused << 16 | nblocks << 32 | vflag << 40
+  uint64_t sig;
+
+  bool operator==(const tpstate &rhs) const {
+    return (lo == rhs.lo) && (sig == rhs.sig);
+  }
+};
+
+struct tpstate_hash {
+  size_t operator()(const tpstate &s) const {
+    return std::hash<uint64_t>()(s.lo * 0x9e3779b97f4a7c15ull ^ s.sig);
+  }
+};
+
+using tpmap = std::unordered_map<tpstate, size_t, tpstate_hash>;
+
+inline tpstate tp_make(uint64_t cuts, uint64_t hused, uint64_t nblocks,
+                       bool vflag, uint64_t sig) {
+  return tpstate{cuts | (hused << 16) | (nblocks << 32) |
+                     (uint64_t(vflag) << 40),
+                 vflag ? sig : 0};
+}
+
+inline void tp_add(tpmap &m, const tpstate &s, size_t cnt) {
+  auto &c = m[s];
+  if (__builtin_add_overflow(c, cnt, &c))
+    throw std::overflow_error("Tight pavings count overflow");
+}
+
+// adds one column with nseg blocks to packed signature
+inline uint64_t tp_sig(uint64_t sig, size_t nseg) {
+  return sig + (uint64_t(1) << (4 * (nseg - 1)));
+}
+
+// is there block [a, b) in column cut by cuts
+inline bool tp_has_block(uint64_t cuts, size_t a, size_t b, size_t M) {
+  uint64_t inner = ((uint64_t(1) << (b - 1)) - 1) & ~((uint64_t(1) << a) - 1);
+  return ((cuts & inner) == 0) && ((a == 0) || ((cuts >> (a - 1)) & 1)) &&
+         ((b == M) || ((cuts >> (b - 1)) & 1));
+}
+
+// with_vtype = false counts only tight pavings, which is way faster
+inline tpcounts count_tight_pavings(size_t N, size_t M, bool with_vtype) {
+  assert(N >= 2 && M >= 2);
+
+  // number of tight pavings is symmetric, so sweep along longer side
+  if (!with_vtype && (M > N))
+    std::swap(N, M);
+
+  if ((M > 17) || (with_vtype && ((M > 16) || (N > 15))))
+    throw std::runtime_error("Field is too large for transfer matrix");
+
+  size_t maxblocks = M + N - 1;
+  uint64_t lines = (uint64_t(1) << (M - 1)) - 1;
+  tpmap cur, next;
+
+  // column 0: any cut of it
+  for (uint64_t cuts = 0; cuts <= lines; ++cuts) {
+    size_t nseg = __builtin_popcountll(cuts) + 1;
+    tp_add(cur, tp_make(cuts, cuts, nseg, with_vtype, tp_sig(0, nseg)), 1);
+  }
+
+  for (size_t x = 1; x < N; ++x) {
+    next.clear();
+    for (auto &sc : cur) {
+      uint64_t cuts = sc.first.lo & 0xffff;
+      uint64_t hused = (sc.first.lo >> 16) & 0xffff;
+      size_t nblocks = (sc.first.lo >> 32) & 0xff;
+      bool vflag = (sc.first.lo >> 40) & 1;
+      uint64_t sig = sc.first.sig;
+
+      // segments of column x: starts and ends
+      std::vector<size_t> sb{0}, se;
+      for (size_t i = 0; i + 1 < M; ++i)
+        if ((cuts >> i) & 1) {
+          se.push_back(i + 1);
+          sb.push_back(i + 1);
+        }
+      se.push_back(M);
+      size_t nseg = sb.size();
+
+      // every remaining column adds at least one block
+      if (nblocks + (N - x) > maxblocks)
+        continue;
+
+      // cont is set of continued blocks, at least one block ends
+      for (uint64_t cont = 0; cont + 1 < (uint64_t(1) << nseg); ++cont) {
+        uint64_t freerows = 0;
+        for (size_t s = 0; s < nseg; ++s)
+          if (!((cont >> s) & 1))
+            freerows |= ((uint64_t(1) << se[s]) - 1) &
+                        ~((uint64_t(1) << sb[s]) - 1);
+
+        // boundaries inside free runs may be cut in any way
+        uint64_t freecuts = freerows & (freerows >> 1) & lines;
+        uint64_t fixed = cuts & ~freecuts;
+        uint64_t chosen = freecuts;
+
+        for (;;) {
+          uint64_t ncuts = fixed | chosen;
+          size_t nnew = 0;
+          bool nvflag = vflag;
+
+          for (size_t a = 0; a < M;) {
+            size_t b = a + 1;
+            while ((b < M) && !((ncuts >> (b - 1)) & 1))
+              b += 1;
+            if ((freerows >> a) & 1) {
+              nnew += 1;
+              if (nvflag && tp_has_block(cuts, a, b, M))
+                nvflag = false;
+            }
+            a = b;
+          }
+
+          if (nblocks + nnew <= maxblocks) {
+            size_t nsegnew = __builtin_popcountll(ncuts) + 1;
+            tp_add(next,
+                   tp_make(ncuts, hused | ncuts, nblocks + nnew,
+                           nvflag && with_vtype, tp_sig(sig, nsegnew)),
+                   sc.second);
+          }
+
+          if (chosen == 0)
+            break;
+          chosen = (chosen - 1) & freecuts;
+        }
+      }
+    }
+    std::swap(cur, next);
+  }
+
+  tpcounts res;
+  for (auto &sc : cur) {
+    uint64_t hused = (sc.first.lo >> 16) & 0xffff;
+    size_t nblocks = (sc.first.lo >> 32) & 0xff;
+    bool vflag = (sc.first.lo >> 40) & 1;
+    if ((hused != lines) || (nblocks != maxblocks))
+      continue;
+    if (__builtin_add_overflow(res.count_tp, sc.second, &res.count_tp))
+      throw std::overflow_error("Tight pavings count overflow");
+    if (!vflag)
+      continue;
+    res.count_vt += sc.second;
+    std::vector<size_t> v;
+    for (size_t val = 1; val <= M; ++val)
+      for (size_t k = 0; k < ((sc.first.sig >> (4 * (val - 1))) & 0xf); ++k)
+        v.push_back(val);
+    res.genfunc[v] += sc.second;
+  }
+  return res;
+}
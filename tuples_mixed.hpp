@@ -2,7 +2,27 @@
 //
 // this file implements all mixed mode tuples
 //
-// Details may be found in Knuth, algorithm M from 7.2.1.1 (vol 4A)
+// MixedModeTuple counts as odometer, last digit is the fastest one
+// rank is number of tuple in this order, so tuples may be visited from any
+// place: unrank(k) goes to tuple k and advance(k) goes k tuples forward
+//
+// next_batch writes many tuples at once as columns, one column per digit.
+// Digit j repeats every its value place_j = borders[j + 1] * ... times, so
+// column is filled by runs of equal values, without any carry per tuple:
+//
+//  radices 2, 3, tuples 1 .. 4:    column 0: 0 0 1 1
+//                                  column 1: 1 2 0 1
+// GrayModeTuple is reflected Gray code: every step changes exactly one digit
+// by +1 or -1 in O(1), say for radices 2, 3
+//
+//  0 0
+//  0 1    changed() == 1, delta() == +1
+//  0 2    changed() == 1, delta() == +1
+//  1 2    changed() == 0, delta() == +1
+//  1 1    changed() == 1, delta() == -1
+//  1 0    changed() == 1, delta() == -1
+//
+// Details may be found in Knuth, algorithms M and H from 7.2.1.1 (vol 4A)
 //
 //------------------------------------------------------------------------------
 //
@@ -11,6 +31,12 @@
 //
 //------------------------------------------------------------------------------
 
+#pragma once
+
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <stdexcept>
 #include <vector>
 
 class MixedModeTuple {
@@ -39,6 +65,130 @@ public:
     return true;
   }
 
+  // number of all tuples
+  size_t count() const {
+    size_t res = 1;
+    for (auto b : borders_)
+      if (__builtin_mul_overflow(res, size_t(b), &res))
+        throw std::overflow_error("Mixed mode tuples count overflow");
+    return res;
+  }
+
+  size_t rank() const {
+    size_t res = 0;
+    for (int j = 0; j < len_; ++j)
+      res = res * borders_[j] + result_[j];
+    return res;
+  }
+
+  void unrank(size_t k) {
+    assert(k < count());
+    for (int j = len_; j > 0; --j) {
+      result_[j - 1] = k % borders_[j - 1];
+      k /= borders_[j - 1];
+    }
+  }
+
+  // k steps of next_tuple at once, that is k added with carry
+  // false if it wraps around, just as next_tuple do
+  bool advance(size_t k) {
+    for (int j = len_; (j > 0) && (k > 0); --j) {
+      size_t sum = result_[j - 1] + k;
+      result_[j - 1] = sum % borders_[j - 1];
+      k = sum / borders_[j - 1];
+    }
+    return k == 0;
+  }
+
+  // up to k tuples, starting from current one: digit j of tuple i goes to
+  // out[j * k + i], cnt is number of tuples written, no tuple after the last
+  // one is written. Current tuple goes to the one after them and false is
+  // returned if it wraps around, just as next_tuple do
+  template <typename OutIt> bool next_batch(OutIt out, size_t k, size_t &cnt) {
+    assert(k > 0);
+    size_t total = count(), cur = rank();
+    cnt = std::min(k, total - cur);
+
+    size_t place = 1;
+    for (int j = len_; j > 0; --j) {
+      size_t b = borders_[j - 1];
+      auto col = out + (j - 1) * k;
+      int v = result_[j - 1];
+      for (size_t i = 0, run = place - cur % place; i < cnt; run = place) {
+        size_t len = std::min(run, cnt - i);
+        std::fill(col + i, col + i + len, v);
+        i += len;
+        v = (size_t(v) + 1 == b) ? 0 : v + 1;
+      }
+      place *= b;
+    }
+
+    return advance(cnt);
+  }
+
+  auto begin() { return result_.begin(); }
+  auto end() { return result_.end(); }
+};
+
+class GrayModeTuple {
+  std::vector<int> borders_, result_;
+
+  // digits with radix > 1 in Knuth order: pos_[0] is the fastest one,
+  // with focus pointers focus_ and directions dir_, see H1
+  std::vector<int> pos_, focus_, dir_;
+  int changed_ = -1, delta_ = 0;
+
+public:
+  template <typename It>
+  GrayModeTuple(It start, It fin) : borders_(start, fin),
+                                    result_(borders_.size()) {
+    for (int j = borders_.size(); j > 0; --j) {
+      assert(borders_[j - 1] > 0 && "Radix shall be positive");
+      if (borders_[j - 1] > 1)
+        pos_.push_back(j - 1);
+    }
+    focus_.resize(pos_.size() + 1);
+    for (size_t j = 0; j <= pos_.size(); ++j)
+      focus_[j] = j;
+    dir_.assign(pos_.size(), 1);
+  }
+
+  bool next_tuple() {
+    int n = pos_.size();
+
+    /* H3 */
+    int j = focus_[0];
+    focus_[0] = 0;
+
+    /* H4 */
+    if (j == n) {
+      // all digits are at their ends with reversed directions, so from
+      // here the same code is walked backwards
+      for (int k = 0; k <= n; ++k)
+        focus_[k] = k;
+      changed_ = -1;
+      delta_ = 0;
+      return false;
+    }
+
+    int p = pos_[j];
+    result_[p] += dir_[j];
+    changed_ = p;
+    delta_ = dir_[j];
+
+    /* H5 */
+    if ((result_[p] == 0) || (result_[p] == borders_[p] - 1)) {
+      dir_[j] = -dir_[j];
+      focus_[j] = focus_[j + 1];
+      focus_[j + 1] = j + 1;
+    }
+    return true;
+  }
+
+  // digit changed by last step and by how much, -1 and 0 before first step
+  int changed() const { return changed_; }
+  int delta() const { return delta_; }
+
   auto begin() { return result_.begin(); }
   auto end() { return result_.end(); }
 };
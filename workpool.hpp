@@ -0,0 +1,118 @@
+//------------------------------------------------------------------------------
+//
+// Simple work-stealing pool for independent work units
+//
+// Usage:
+//
+//  StealingPool<Unit> pool(nthreads);
+//  for (auto &u : units)
+//    pool.push(u);
+//  pool.run([&](size_t tid, Unit &u) { ... });
+//
+// Units are dealt round-robin to per-thread deques before run. Every thread
+// takes work from the back of its own deque and, when it runs dry, steals
+// from the front of its neighbours. Each callback gets thread id, so caller
+// may keep per-thread state in vector indexed by tid without locking.
+//
+// If callback throws, other threads finish their current units and take no
+// more, then run rethrows first exception in calling thread.
+//
+//------------------------------------------------------------------------------
+//
+// This file is licensed after LGPL v3
+// Look at: https://www.gnu.org/licenses/lgpl-3.0.en.html for details
+//
+//------------------------------------------------------------------------------
+
+#pragma once
+
+#include <atomic>
+#include <cassert>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+template <typename Unit> class StealingPool {
+  struct Queue {
+    std::mutex mut;
+    std::deque<Unit> units;
+  };
+
+  std::vector<Queue> queues_;
+  size_t next_ = 0;
+
+  bool pop_own(size_t tid, Unit &u) {
+    auto &q = queues_[tid];
+    std::lock_guard<std::mutex> lk(q.mut);
+    if (q.units.empty())
+      return false;
+    u = std::move(q.units.back());
+    q.units.pop_back();
+    return true;
+  }
+
+  bool steal(size_t tid, Unit &u) {
+    for (size_t shift = 1; shift < queues_.size(); ++shift) {
+      auto &q = queues_[(tid + shift) % queues_.size()];
+      std::lock_guard<std::mutex> lk(q.mut);
+      if (q.units.empty())
+        continue;
+      u = std::move(q.units.front());
+      q.units.pop_front();
+      return true;
+    }
+    return false;
+  }
+
+public:
+  StealingPool(size_t nthreads) : queues_(nthreads) {
+    assert(nthreads > 0);
+  }
+
+  size_t nthreads() const { return queues_.size(); }
+
+  // shall be called before run
+  void push(Unit u) {
+    queues_[next_].units.push_front(std::move(u));
+    next_ = (next_ + 1) % queues_.size();
+  }
+
+  // nobody pushes during run, so empty queues everywhere means we are done
+  template <typename F> void run(F f) {
+    std::atomic<bool> stop{false};
+    std::mutex errmut;
+    std::exception_ptr err;
+    auto fail = [&] {
+      std::lock_guard<std::mutex> lk(errmut);
+      if (!err)
+        err = std::current_exception();
+      stop = true;
+    };
+
+    auto worker = [&](size_t tid) {
+      try {
+        Unit u;
+        while (!stop && (pop_own(tid, u) || steal(tid, u)))
+          f(tid, u);
+      } catch (...) {
+        fail();
+      }
+    };
+
+    // threads are always joined, even if some of them failed to start
+    std::vector<std::thread> threads;
+    try {
+      for (size_t tid = 1; tid < queues_.size(); ++tid)
+        threads.emplace_back(worker, tid);
+    } catch (...) {
+      fail();
+    }
+    worker(0);
+    for (auto &t : threads)
+      t.join();
+    if (err)
+      std::rethrow_exception(err);
+  }
+};